@@ -8,18 +8,60 @@
 #include <stdexcept>
 #include <bit>
 #include <memory>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <bitset>
 #include <cmath>
 #include <concepts>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <istream>
 #include <map>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
+#include <ranges>
 #include <set>
+#include <span>
+#include <thread>
 #include <unordered_set>
 #include <variant>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define BSP_POSIX 1
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// Without exceptions (-fno-exceptions, or BSP_NO_EXCEPTIONS defined), errors go to errors::fatal_handler
+// and abort. try_read / try_write still report decoding errors as codes.
+#if !defined(BSP_NO_EXCEPTIONS) && !defined(__cpp_exceptions)
+#define BSP_NO_EXCEPTIONS 1
+#endif
+
+#ifdef BSP_NO_EXCEPTIONS
+#define BSP_THROW(...) ::bsp::errors::fatal(__VA_ARGS__)
+#define BSP_RETHROW std::abort()
+#define BSP_TRY if (true)
+#define BSP_CATCH_ALL else if (false)
+#else
+#define BSP_THROW(...) throw __VA_ARGS__
+#define BSP_RETHROW throw
+#define BSP_TRY try
+#define BSP_CATCH_ALL catch (...)
+#endif
+
 
 // =============================================================================
 // BSP (Byte Schema Protocol)
@@ -75,6 +117,54 @@ namespace bsp {
          */
         struct DynSchema;
 
+        /**
+         * @brief Self-describing schema encoding.
+         * @details Writes the schema version picked by context::options::target_schema_version in a header,
+         * readers dispatch to the matching schema version from it.
+         * @tparam Sized Whether the header carries the payload length, which allows skipping newer fields.
+         */
+        template<bool Sized>
+        struct Versioned;
+
+        /**
+         * @brief Tagged schema encoding.
+         * @details Every field is prefixed with a varint tag (field id, wire type), the message ends with tag 0.
+         * Readers match fields by id and skip unknown ones through their wire type.
+         * @see BSP_FIELD_ID
+         * @tparam Version The schema version number.
+         */
+        template<size_t Version>
+        struct Tagged;
+
+        /**
+         * @brief Random-access container encoding.
+         * @details Writes a bit-packed offset table before the payload, so that one element can be decoded
+         * without decoding the ones before it.
+         * @see indexed_view
+         * @tparam Inner Protocol for encoding the elements.
+         */
+        template<typename Inner>
+        struct Indexed;
+
+        /**
+         * @brief Chunked container encoding.
+         * @details Splits a container into independently encoded chunks behind a chunk directory,
+         * so that chunks can be encoded and decoded concurrently on context::options::pool.
+         * The data can still be read sequentially.
+         * @tparam Inner Protocol for encoding the elements (the values for maps).
+         */
+        template<typename Inner>
+        struct Chunked;
+
+        /**
+         * @brief Columnar (struct-of-arrays) encoding for containers of schema structs.
+         * @details Writes each schema field of all elements as one column, encoded with the field's protocol.
+         * @see columns
+         * @tparam Version The schema version number.
+         */
+        template<size_t Version>
+        struct Columnar;
+
         /**
          * @brief Length-limited encoding.
          * @details Throwing errors when you write/read too much.
@@ -112,6 +202,13 @@ namespace bsp {
          * @details Types inheriting from CVal can be serialized through base pointers.
          */
         struct CVal;
+
+        /**
+         * @brief Refcounted read-only byte range, wire-compatible with types::bytes.
+         * @details Shares ownership of the buffer it points into, so slices decoded from a SliceReader
+         * need no copy and may outlive the reader or move to other threads.
+         */
+        class slice;
     }
 
     // === Schema Versioning ===================================================
@@ -127,19 +224,102 @@ namespace bsp {
         struct SchemaSet;
     }
 
+    // === Lazy Views ==========================================================
+    // 惰性视图
+    /**
+     * @brief View over an encoded schema message that decodes fields on first access.
+     * @details Works on a contiguous buffer written with Schema<Version>. Offsets found while skipping
+     * untouched fields and decoded values are cached. The buffer must outlive the view. Not thread-safe.
+     * @tparam T The schema struct type.
+     * @tparam Version The schema version number.
+     */
+    template<typename T, size_t Version = SIZE_MAX>
+    class lazy;
+
+    /**
+     * @brief View over an encoded Indexed<Inner> vector that decodes single elements or ranges.
+     * @details Works on a contiguous buffer. The buffer must outlive the view.
+     * @tparam T The element type.
+     * @tparam Inner Protocol the elements were written with.
+     */
+    template<typename T, typename Inner = proto::Default>
+    class indexed_view;
+
+    // === Struct of Arrays ====================================================
+    // 列式存储
+    /**
+     * @brief Struct-of-arrays holder for a schema struct, one std::vector per field.
+     * @details Default protocol is Columnar<Version>, the same format as std::vector<T> with Columnar<Version>.
+     * @tparam T The schema struct type.
+     * @tparam Version The schema version number.
+     */
+    template<typename T, size_t Version = SIZE_MAX>
+    struct columns;
+
+    // === Parallel Execution ==================================================
+    // 并行执行
+    namespace parallel {
+        /**
+         * @brief Fixed-size thread pool used by concurrent protocols.
+         * @details Set context::options::pool to let Chunked protocols run on it.
+         */
+        class thread_pool;
+
+        /**
+         * @brief Encodes batches of independent messages on a thread pool.
+         * @details Output order follows input order. Per-worker contexts and message buffers are reused
+         * between batches. One batch at a time, not thread-safe.
+         * @tparam T The message type.
+         * @tparam Proto Protocol every message is written with.
+         */
+        template<typename T, typename Proto = proto::Default>
+        class batch_encoder;
+    }
+
     // === Serializer Interface ================================================
     // 序列化接口
     namespace serialize {
         /**
          * @brief Serialize interface for all types & protocols.
          * @details Interface: <br/>
-         * static void write(io::Writer auto &w, const T &v, context &ctx); <br/>
-         * static void read(io::Reader auto &r, T &out, context &ctx);
+         * static void write(io::Writer auto &w, const T &v, context_like auto &ctx); <br/>
+         * static void read(io::Reader auto &r, T &out, context_like auto &ctx);
          */
         template<typename T, typename P>
         struct Serializer;
     }
 
+    // === Errors Handling & Traceback =========================================
+    // 错误处理与调用栈
+    namespace errors {
+        /**
+         * @brief Error handling policy.
+         * @details STRICT: throw on any anomaly. <br/>
+         * MEDIUM: tolerate recoverable anomalies. <br/>
+         * IGNORE: skip anomalies silently.
+         */
+        enum class error_policy: uint8_t;
+        /**
+         * @brief Specific error codes.
+         */
+        enum class code: uint32_t;
+        /**
+         * @brief Error category.
+         */
+        enum class kind: uint8_t;
+
+        /**
+         * @brief Call stack trace for error diagnostics.
+         * @details Captures the serialization path when an error occurs.
+         */
+        struct traceback;
+
+        /**
+         * @brief Exception type for all bsp errors.
+         */
+        struct error;
+    }
+
     // === I/O Interface =======================================================
     // I/O 读写接口
     namespace io {
@@ -159,6 +339,71 @@ namespace bsp {
             { w.write_bytes(buf, n) } -> std::same_as<void>;
             { w.write_byte(b) } -> std::same_as<void>;
         };
+        /**
+         * @brief Concept for a reader backed by contiguous memory.
+         * @details borrow_bytes(n) checks the bounds once and returns a pointer to the next n bytes.
+         * The pointer is valid until the next read.
+         */
+        template<typename R> concept ContiguousReader = Reader<R> && requires(R r, const size_t n)
+        {
+            { r.borrow_bytes(n) } -> std::same_as<const uint8_t *>;
+        };
+        /**
+         * @brief Concept for a writer backed by contiguous memory.
+         * @details reserve_bytes(n) checks the capacity once and returns a pointer to n writable bytes.
+         * The pointer is valid until the next write.
+         */
+        template<typename W> concept ContiguousWriter = Writer<W> && requires(W w, const size_t n)
+        {
+            { w.reserve_bytes(n) } -> std::same_as<uint8_t *>;
+        };
+        /**
+         * @brief Concept for a reader that knows how many unread bytes it holds.
+         */
+        template<typename R> concept SizedReader = Reader<R> && requires(const R r)
+        {
+            { r.remaining() } -> std::same_as<size_t>;
+        };
+        /**
+         * @brief Concept for a reader that can skip bytes without copying them.
+         */
+        template<typename R> concept SkippingReader = Reader<R> && requires(R r, const size_t n)
+        {
+            { r.skip(n) } -> std::same_as<void>;
+        };
+        /**
+         * @brief Concept for a writer that can keep references to large payloads instead of copying them.
+         * @details write_borrowed(p, n) may keep p; the memory must stay valid until the output is consumed.
+         * Serializers use it only for bytes owned by the value being written.
+         */
+        template<typename W> concept BorrowingWriter = Writer<W> && requires(W w, const uint8_t *p, const size_t n)
+        {
+            { w.write_borrowed(p, n) } -> std::same_as<void>;
+        };
+        /**
+         * @brief Concept for a reader that records failures instead of throwing.
+         * @details fail(c) records c if no failure is recorded yet. A failed reader returns zeros.
+         */
+        template<typename R> concept FallibleReader = Reader<R> && requires(R r, const errors::code c)
+        {
+            { r.fail(c) } -> std::same_as<void>;
+        };
+        /**
+         * @brief Concept for a writer that records failures instead of throwing.
+         * @details fail(c) records c if no failure is recorded yet. A failed writer discards its input.
+         */
+        template<typename W> concept FallibleWriter = Writer<W> && requires(W w, const errors::code c)
+        {
+            { w.fail(c) } -> std::same_as<void>;
+        };
+        /**
+         * @brief Concept for a reader over a refcounted buffer.
+         * @details borrow_slice(n) returns the next n bytes as a types::slice sharing the buffer.
+         */
+        template<typename R> concept SharingReader = Reader<R> && requires(R r, const size_t n)
+        {
+            { r.borrow_slice(n) } -> std::same_as<types::slice>;
+        };
 
         /**
          * @brief Writer wrapping a std::ostream.
@@ -181,6 +426,51 @@ namespace bsp {
          * @brief Reader backed by a raw byte buffer.
          */
         struct BytesReader;
+        /**
+         * @brief Reader over a sequence of non-contiguous byte spans, e.g. a chain of received packets.
+         * @details Values may cross span boundaries. The spans must outlive the reader.
+         */
+        struct SegmentedReader;
+        /**
+         * @brief Reader over a types::slice, handing out sub-slices without copying.
+         */
+        struct SliceReader;
+        /**
+         * @brief Reader over a raw byte buffer that never throws, for try_read.
+         * @details The first failure is kept in error, after which reads return zeros.
+         */
+        struct CheckedReader;
+        /**
+         * @brief Writer that only counts the bytes written.
+         * @details Used as a size pre-pass when a length must precede the payload.
+         */
+        struct CountingWriter;
+        /**
+         * @brief Writer into a fixed raw byte range.
+         * @details Throws when writing past the end of the range.
+         */
+        struct SpanWriter;
+        /**
+         * @brief Writer into a fixed raw byte range that never throws, for try_write.
+         * @details The first failure is kept in error, after which writes are discarded.
+         */
+        struct CheckedWriter;
+        /**
+         * @brief Writer that collects output as a list of segments for writev/sendmsg.
+         * @details Small writes are coalesced into owned chunks, large payloads are referenced in place.
+         */
+        class ScatterWriter;
+        /**
+         * @brief Writer that fills buffers while a background thread flushes the filled ones.
+         * @details Writes to a std::ostream or a file descriptor. I/O errors are reported by the next
+         * buffer hand-off, flush() or close().
+         */
+        class AsyncWriter;
+        /**
+         * @brief Reader that fills buffers on a background thread ahead of the decoding thread.
+         * @details Reads from a std::istream or a file descriptor, for sequential scans of large inputs.
+         */
+        class PrefetchReader;
 
         /**
          * @brief Reader that limits the number of readable bytes.
@@ -203,37 +493,37 @@ namespace bsp {
          * @brief Type-erased writer (virtual dispatch).
          */
         struct AnyWriter;
-    }
 
-    // === Errors Handling & Traceback =========================================
-    // 错误处理与调用栈
-    namespace errors {
+#ifdef BSP_POSIX
         /**
-         * @brief Error handling policy.
-         * @details STRICT: throw on any anomaly. <br/>
-         * MEDIUM: tolerate recoverable anomalies. <br/>
-         * IGNORE: skip anomalies silently.
+         * @brief Append-only record log on a mmap'd file, shared by concurrent writers.
+         * @details Writers reserve space with an atomic fetch-add and publish each record with a commit marker.
          */
-        enum class error_policy: uint8_t;
+        class RecordLog;
         /**
-         * @brief Specific error codes.
+         * @brief Reader tailing a RecordLog, skipping aborted and torn records.
          */
-        enum class code: uint32_t;
+        class RecordLogReader;
         /**
-         * @brief Error category.
+         * @brief Producer side of a shared-memory message ring.
+         * @details Lock-free. Several producers may share a ring created with multi_producer set.
          */
-        enum class kind: uint8_t;
-
+        class ShmRingWriter;
         /**
-         * @brief Call stack trace for error diagnostics.
-         * @details Captures the serialization path when an error occurs.
+         * @brief Consumer side of a shared-memory message ring, reading one message at a time.
          */
-        struct traceback;
-
+        class ShmRingReader;
         /**
-         * @brief Exception type for all bsp errors.
+         * @brief Buffered reader over a file descriptor.
+         * @details Large reads go straight into the destination, with the internal buffer refilled in the same readv.
          */
-        struct error;
+        class FdReader;
+        /**
+         * @brief Buffered writer over a file descriptor.
+         * @details Large payloads are not copied: buffered bytes and the payload leave in one writev.
+         */
+        class FdWriter;
+#endif
     }
 
     // === Details & Helpers ===================================================
@@ -253,9 +543,23 @@ namespace bsp {
     // 单次调用级状态
     struct status;
 
-    // --- Context -------------------------------------------------------------
-    // 上下文
-    struct context;
+    // --- Compile-Time Policy -------------------------------------------------
+    // 编译期策略
+    /**
+     * @brief Checks a context fixes at compile time: traceback, size and depth limits, error policy.
+     * @details basic_context<P> compiles the checks P turns off out of every serializer.
+     * context is basic_context<policies::runtime>, which reads them from safety at runtime.
+     */
+    struct policy;
+
+    // --- Result --------------------------------------------------------------
+    // 结果
+    /**
+     * @brief A value or the errors::code that prevented it, returned by try_read / try_write.
+     * @tparam T The value type, void for try_write.
+     */
+    template<typename T>
+    class result;
 } // namespace bsp
 
 
@@ -309,16 +613,65 @@ namespace bsp {
 
         // --- Traceback -------------------------------------------------------
         // 调用栈记录
+
+        // Text of a frame, put together only when the traceback is formatted.
+        // Static strings and an index cost no allocation, an owned string is kept for anything else.
+        struct frame_text {
+            const char *head = nullptr;
+            const char *middle = nullptr;
+            std::optional<size_t> number;
+            const char *tail = nullptr;
+            std::string owned;
+
+            frame_text() = default;
+
+            frame_text(const char *text) : head(text) {
+            }
+
+            frame_text(std::string text) : owned(std::move(text)) {
+            }
+
+            // head, middle, tail: "Field \"", name, "\""
+            frame_text(const char *head, const char *middle, const char *tail = nullptr) : head(head), middle(middle),
+                tail(tail) {
+            }
+
+            // head, number, tail: "Elem ", index or "Fixed<", N, ">"
+            frame_text(const char *head, const size_t number, const char *tail = nullptr) : head(head),
+                number(number), tail(tail) {
+            }
+
+            // head, middle, number: "Versioned<true>", " version=", version
+            frame_text(const char *head, const char *middle, const size_t number) : head(head), middle(middle),
+                number(number) {
+            }
+
+            [[nodiscard]] bool empty() const {
+                return head == nullptr && owned.empty();
+            }
+
+            void append_to(std::string &out) const {
+                if (head == nullptr) {
+                    out.append(owned);
+                    return;
+                }
+                out.append(head);
+                if (middle != nullptr) out.append(middle);
+                if (number.has_value()) out.append(std::to_string(*number));
+                if (tail != nullptr) out.append(tail);
+            }
+        };
+
         struct wrapper_frame {
-            std::string wrapper_info;
+            frame_text wrapper_info;
         };
 
         struct value_frame {
-            std::string type;
-            std::string proto;
+            frame_text type;
+            frame_text proto;
 
-            const std::optional<std::string> child_label;
-            const std::optional<std::string> details;
+            frame_text child_label; // Empty when unknown
+            frame_text details; // Empty when none
         };
 
         using traceback_frame = std::variant<wrapper_frame, value_frame>;
@@ -330,13 +683,50 @@ namespace bsp {
         };
 
         struct traceback {
-            std::vector<traceback_frame> frames;
+            std::vector<traceback_frame> frames; // Innermost first
+            size_t capacity = 0; // Frames kept, 0 for no bound
+            size_t dropped = 0; // Outer frames that did not fit
+
+            // Preallocates capacity frames, recording then allocates only for owned frame text.
+            // Once full, the innermost frames are kept and outer frames are only counted.
+            // Example: ctx.traceback = errors::traceback::bounded(32);
+            static std::shared_ptr<traceback> bounded(const size_t capacity) {
+                auto tb = std::make_shared<traceback>();
+                tb->frames.reserve(capacity);
+                tb->capacity = capacity;
+                return tb;
+            }
+
+            // Starts the traceback of a new error: the frames of the last one are cleared in place,
+            // unless an earlier error still holds them, then tb is replaced by an empty traceback.
+            static void restart(std::shared_ptr<traceback> &tb) {
+                if (tb == nullptr) return;
+                if (tb.use_count() > 1) {
+                    tb = tb->capacity == 0 ? std::make_shared<traceback>() : bounded(tb->capacity);
+                    return;
+                }
+                tb->frames.clear();
+                tb->dropped = 0;
+            }
+
+            void push(traceback_frame frame) {
+                if (capacity == 0 || frames.size() < capacity) {
+                    frames.push_back(std::move(frame));
+                } else {
+                    ++dropped;
+                }
+            }
 
             [[nodiscard]] std::string format() const {
+                static const frame_text root = "[ROOT]", unknown = "[UNKNOWN]";
                 std::string result = "Traceback:\n";
+                if (dropped != 0) {
+                    result.append(detail::concat("  ... outer frames dropped: ", dropped, "\n"));
+                }
 
                 bool newline = false;
-                std::string label = "[ROOT]";
+                // The outermost kept frame is labelled by a dropped one
+                const frame_text *label = dropped == 0 ? &root : &unknown;
 
                 for (size_t i = frames.size(); i > 0; --i) {
                     if (newline) {
@@ -348,19 +738,25 @@ namespace bsp {
                     if (frame.index() == 0) {
                         const auto &wrapper = std::get<0>(frame);
 
-                        result.append(detail::concat("  @ ", wrapper.wrapper_info, "\n"));
+                        result.append("  @ ");
+                        wrapper.wrapper_info.append_to(result);
+                        result.push_back('\n');
                     } else {
                         const auto &value = std::get<1>(frame);
 
-                        result.append(detail::concat("  - ", label, " | ", value.type, ", ", value.proto, "\n"));
-                        if (value.child_label.has_value()) {
-                            label = value.child_label.value();
-                        } else {
-                            label = "[UNKNOWN]";
-                        }
+                        result.append("  - ");
+                        label->append_to(result);
+                        result.append(" | ");
+                        value.type.append_to(result);
+                        result.append(", ");
+                        value.proto.append_to(result);
+                        result.push_back('\n');
+                        label = value.child_label.empty() ? &unknown : &value.child_label;
 
-                        if (value.details.has_value()) {
-                            result.append(detail::concat("    (", value.details.value(), ")\n"));
+                        if (!value.details.empty()) {
+                            result.append("    (");
+                            value.details.append_to(result);
+                            result.append(")\n");
                         }
 
                         newline = true;
@@ -379,7 +775,7 @@ namespace bsp {
     // Therefore, you can modify these constexpr options in this file:
 
     static constexpr inline auto endian = std::endian::big;
-    static constexpr inline bool enable_traceback = true;
+    static constexpr inline bool enable_traceback = true; // Default of policy::traceback
 
     // --- Safety Options ------------------------------------------------------
     // 防御性配置
@@ -403,23 +799,57 @@ namespace bsp {
     // 会话级配置
     struct option {
         size_t target_schema_version;
+        parallel::thread_pool *pool; // Runs Chunked protocols concurrently, nullptr for sequential
+        size_t chunk_size; // Elements per chunk written by Chunked
+        std::pmr::memory_resource *resource; // Backs pmr containers read() finds on the default resource, or nullptr
 
         static option default_option;
     };
 
     inline option option::default_option{
-        .target_schema_version = SIZE_MAX
+        .target_schema_version = SIZE_MAX,
+        .pool = nullptr,
+        .chunk_size = 64 * 1024,
+        .resource = nullptr
     };
 
     // --- Process Level Status ------------------------------------------------
     // 单次调用级状态
     struct status {
         size_t current_depth = 0;
+        std::optional<errors::code> *failure = nullptr; // Set by try_read / try_write: errors are recorded, not thrown
+    };
+
+    // --- Compile-Time Policy -------------------------------------------------
+    // 编译期策略
+    // What a policy turns off is not compiled in, the safety fields it would read are ignored
+    struct policy {
+        bool traceback = enable_traceback; // Record traceback frames while an error unwinds
+        bool limits = true; // Check max_depth, max_container_size and max_string_size
+        bool fixed = false; // Check as error_policy says instead of safety::policy
+        errors::error_policy error_policy = errors::error_policy::MEDIUM;
     };
 
+    namespace policies {
+        // Checks follow safety at runtime
+        inline constexpr policy runtime{};
+
+        // Untrusted input: every check, with traceback
+        inline constexpr policy untrusted{.fixed = true, .error_policy = errors::error_policy::STRICT};
+
+        // Trusted internal traffic: no checks and no scope guards.
+        // Without the depth limit, a pointer cycle recurses until the stack runs out.
+        inline constexpr policy trusted{
+            .traceback = false, .limits = false, .fixed = true, .error_policy = errors::error_policy::IGNORE
+        };
+    }
+
     // --- Context -------------------------------------------------------------
     // 上下文
-    struct context {
+    template<policy P = policies::runtime>
+    struct basic_context {
+        static constexpr bsp::policy policy = P;
+
         safety sf;
         option opt;
         status st;
@@ -444,11 +874,15 @@ namespace bsp {
             errors::trace_frame_generator FrameFn>
         scope_guard<GetDeeper, RollbackSafety, RollbackOpts, FrameFn> guard(FrameFn &&frame_fn);
 
-        static context get_default_context();
+        template<errors::trace_frame_generator FrameFn, typename Body>
+        void leaf(FrameFn &&frame_fn, Body &&body);
+
+        static basic_context get_default_context();
     };
 
-    inline context context::get_default_context() {
-        return context{
+    template<policy P>
+    basic_context<P> basic_context<P>::get_default_context() {
+        return basic_context{
             .sf = safety::default_safety,
             .opt = option::default_option,
             .st = status{},
@@ -456,6 +890,47 @@ namespace bsp {
         };
     }
 
+    using context = basic_context<>;
+    using untrusted_context = basic_context<policies::untrusted>;
+    using trusted_context = basic_context<policies::trusted>;
+
+    namespace detail {
+        template<typename T>
+        struct is_context : std::false_type {
+        };
+
+        template<policy P>
+        struct is_context<basic_context<P> > : std::true_type {
+        };
+    }
+
+    // Serializers take any context, so every policy is compiled separately
+    template<typename C>
+    concept context_like = detail::is_context<std::remove_cv_t<C> >::value;
+
+    namespace detail {
+        // Whether ctx checks errors of level
+        template<context_like C>
+        [[nodiscard]] constexpr bool checks([[maybe_unused]] const C &ctx, const errors::error_policy level) {
+            if constexpr (C::policy.fixed)
+                return C::policy.error_policy <= level;
+            else
+                return ctx.sf.policy <= level;
+        }
+
+        // Whether ctx checks sizes against max_container_size and max_string_size
+        template<context_like C>
+        [[nodiscard]] constexpr bool limits(const C &ctx) {
+            if constexpr (C::policy.limits)
+                return checks(ctx, errors::error_policy::MEDIUM);
+            else
+                return false;
+        }
+
+        template<typename C>
+        inline constexpr bool traced = std::remove_cvref_t<C>::policy.traceback;
+    }
+
     // === Error Class =========================================================
     // 错误类
     namespace errors {
@@ -464,6 +939,7 @@ namespace bsp {
         enum class code : uint32_t {
             // IO / Stream
             unexpected_eof,
+            out_of_space,
 
             // Schema / Protocol
             invalid_index,
@@ -497,6 +973,7 @@ namespace bsp {
         [[nodiscard]] constexpr kind classify(const code c) {
             switch (c) {
                 case code::unexpected_eof:
+                case code::out_of_space:
                     return kind::io;
 
                 case code::invalid_index:
@@ -523,6 +1000,7 @@ namespace bsp {
         [[nodiscard]] constexpr const char *nameof(const code c) {
             switch (c) {
                 case code::unexpected_eof: return "unexpected_eof";
+                case code::out_of_space: return "out_of_space";
                 case code::invalid_index: return "invalid_index";
                 case code::fixed_size_mismatch: return "fixed_size_mismatch";
                 case code::duplicate_key: return "duplicate_key";
@@ -565,13 +1043,18 @@ namespace bsp {
             }
         };
 
-        inline error make(
+        error make(
             const code c,
-            context &ctx,
+            context_like auto &ctx,
             std::string msg = {}
         ) {
-            ctx.get_traceback();
-            return error(c, std::move(msg), ctx.traceback);
+            if constexpr (detail::traced<decltype(ctx)>) {
+                traceback::restart(ctx.traceback);
+                ctx.get_traceback();
+                return error(c, std::move(msg), ctx.traceback);
+            } else {
+                return error(c, std::move(msg), nullptr);
+            }
         }
 
         inline error make(
@@ -587,116 +1070,346 @@ namespace bsp {
                 detail::concat("unexpected EOF (expected ", expected, ", got", actual, ") when reading ", stream_type));
         }
 
-        inline error invalid_bool(const uint8_t actual, context &ctx) {
+        error invalid_bool(const uint8_t actual, context_like auto &ctx) {
             return make(
                 code::invalid_bool, ctx,
                 detail::concat("invalid bool value ", actual));
         }
 
-        inline error not_implemented(context &ctx) {
+        error not_implemented(context_like auto &ctx) {
             return make(code::not_implemented, ctx,
                         "feature not implemented");
         }
 
-        inline error fixed_size_mismatch(const size_t expected, const size_t actual, context &ctx) {
+        error fixed_size_mismatch(const size_t expected, const size_t actual, context_like auto &ctx) {
             return make(
                 code::fixed_size_mismatch, ctx,
                 detail::concat("container size ", expected, " mismatches fixed size ", actual));
         }
 
-        inline error depth_limit_exceeded(const size_t limit, context &ctx) {
+        error depth_limit_exceeded(const size_t limit, context_like auto &ctx) {
             return make(
                 code::depth_limit_exceeded, ctx,
                 detail::concat("depth limit", limit, "exceeded")
             );
         }
 
-        inline error container_too_large(const size_t actual, context &ctx) {
+        error container_too_large(const size_t actual, context_like auto &ctx) {
             return make(
                 code::container_too_large, ctx,
                 detail::concat("container size ", actual,
                                " larger than limit=", ctx.sf.max_container_size, " children"));
         }
 
-        inline error string_too_large(const size_t actual, context &ctx) {
+        error string_too_large(const size_t actual, context_like auto &ctx) {
             return make(
                 code::string_too_large, ctx,
                 detail::concat("string size ", actual,
                                " larger than limit=", ctx.sf.max_string_size, " bytes"));
         }
-    }
 
-    // === RAII Guards =========================================================
-    // RAII 限制工具
-    template<bool GetDeeper, bool RollbackSafety, bool RollbackOpts, errors::trace_frame_generator FrameFn>
-    struct context::scope_guard {
-        const std::reference_wrapper<context> ctx;
-        [[no_unique_address, maybe_unused]] FrameFn traceback_frame_fn;
+        // --- Without Exceptions ----------------------------------------------
+        // 无异常模式
 
-    private:
-        [[maybe_unused]] safety origin_sf;
-        [[maybe_unused]] option origin_opt;
-        [[maybe_unused]] size_t origin_depth;
-        [[maybe_unused]] int uncaught_exceptions;
+        // Receives errors that cannot be thrown (BSP_NO_EXCEPTIONS) before the process aborts
+        inline void (*fatal_handler)(const error &) = [](const error &e) {
+            std::fputs(e.what(), stderr);
+            std::fputc('\n', stderr);
+        };
 
-    public:
-        explicit scope_guard(context &ctx,
-                             FrameFn &&frame_fn) : ctx(ctx),
-                                                   traceback_frame_fn(std::forward<FrameFn>(frame_fn)) {
-            if constexpr (GetDeeper) {
-                if (ctx.st.current_depth + 1 > ctx.sf.max_depth)
-                    throw errors::depth_limit_exceeded(ctx.sf.max_depth, ctx);
-                origin_depth = ctx.st.current_depth;
-                ctx.st.current_depth++;
+        [[noreturn]] inline void fatal(const error &e) {
+            fatal_handler(e);
+            std::abort();
+        }
+    }
+
+    namespace detail {
+        // Records c when errors are reported as codes (try_read / try_write), otherwise throws make_error().
+        // Callers return right after. The failed reader then yields zeros, so decoding winds down quickly.
+        template<typename Fn>
+        void fail(context_like auto &ctx, const errors::code c, Fn &&make_error) {
+            if (ctx.st.failure != nullptr) {
+                if (!ctx.st.failure->has_value()) *ctx.st.failure = c;
+                return;
             }
+            BSP_THROW(make_error());
+        }
 
-            if constexpr (RollbackSafety) {
-                origin_sf = ctx.sf;
+        [[nodiscard]] bool failed(const context_like auto &ctx) {
+            return ctx.st.failure != nullptr && ctx.st.failure->has_value();
+        }
+
+        // Records the errors of ctx in slot for the lifetime of the scope
+        template<context_like C>
+        class failure_scope {
+        public:
+            failure_scope(C &ctx, std::optional<errors::code> &slot) : ctx_(ctx), outer_(ctx.st.failure) {
+                ctx.st.failure = &slot;
             }
 
-            if constexpr (RollbackOpts) {
-                origin_opt = ctx.opt;
+            ~failure_scope() { ctx_.st.failure = outer_; }
+
+            failure_scope(const failure_scope &) = delete;
+
+            failure_scope &operator=(const failure_scope &) = delete;
+
+        private:
+            C &ctx_;
+            std::optional<errors::code> *outer_;
+        };
+
+        // Type-erased code (CVal) takes a context, other policies lend it their state for the scope
+        template<context_like C>
+        class runtime_scope {
+        public:
+            explicit runtime_scope(C &ctx) : ctx_(ctx), runtime_{ctx.sf, ctx.opt, ctx.st, std::move(ctx.traceback)} {
+                // The lent safety checks what the policy of ctx would
+                if constexpr (C::policy.fixed)
+                    runtime_.sf.policy = C::policy.error_policy;
+                if constexpr (!C::policy.limits) {
+                    runtime_.sf.max_depth = SIZE_MAX;
+                    runtime_.sf.max_container_size = SIZE_MAX;
+                    runtime_.sf.max_string_size = SIZE_MAX;
+                }
             }
 
-            if constexpr (enable_traceback) {
-                uncaught_exceptions = std::uncaught_exceptions();
+            ~runtime_scope() {
+                ctx_.st = runtime_.st;
+                ctx_.traceback = std::move(runtime_.traceback);
             }
-        }
 
-        ~scope_guard() {
-            if constexpr (GetDeeper) ctx.get().st.current_depth = origin_depth;
-            if constexpr (RollbackSafety) ctx.get().sf = origin_sf;
-            if constexpr (RollbackOpts) ctx.get().opt = origin_opt;
-            if constexpr (enable_traceback)
-                if (std::uncaught_exceptions() > uncaught_exceptions) {
-                    try {
-                        ctx.get().get_traceback().frames.push_back(traceback_frame_fn());
-                    } catch (...) {
-                        ctx.get().get_traceback().frames.emplace_back(errors::wrapper_frame{
-                            "[!!] error when generating traceback info"
-                        });
-                    }
-                }
-        }
+            runtime_scope(const runtime_scope &) = delete;
 
-        scope_guard(const scope_guard &) = delete;
+            runtime_scope &operator=(const runtime_scope &) = delete;
 
-        scope_guard &operator=(const scope_guard &) = delete;
-    };
+            context &get() { return runtime_; }
 
-    // Usage:
-    // auto g = ctx.guard<G, R>([&] { return traceback_frame; });
-    // Set G to true when the serializer is a container
-    // Set R to true when the serializer may modify the options
-    //
-    // The compiler will optimize it, so the lambda function won't cause runtime cost.
+        private:
+            C &ctx_;
+            context runtime_;
+        };
+
+        template<>
+        class runtime_scope<context> {
+        public:
+            explicit runtime_scope(context &ctx) : ctx_(ctx) {
+            }
+
+            context &get() { return ctx_; }
+
+        private:
+            context &ctx_;
+        };
+
+        // Lends the state of ctx to a context whose error policy is fixed to Level for the scope
+        template<context_like C, errors::error_policy Level>
+        class fixed_scope {
+        public:
+            using fixed_context = basic_context<bsp::policy{
+                .traceback = C::policy.traceback, .limits = C::policy.limits, .fixed = true, .error_policy = Level
+            }>;
+
+            explicit fixed_scope(C &ctx) : ctx_(ctx), fixed_{ctx.sf, ctx.opt, ctx.st, std::move(ctx.traceback)} {
+            }
+
+            ~fixed_scope() {
+                ctx_.st = fixed_.st;
+                ctx_.traceback = std::move(fixed_.traceback);
+            }
+
+            fixed_scope(const fixed_scope &) = delete;
+
+            fixed_scope &operator=(const fixed_scope &) = delete;
+
+            fixed_context &get() { return fixed_; }
+
+        private:
+            C &ctx_;
+            fixed_context fixed_;
+        };
+
+        // Runs fn(fixed_ctx) with the runtime error policy of ctx resolved once, so the policy checks
+        // inside fn fold at compile time. fn is compiled once per error policy.
+        template<typename Fn>
+        void with_fixed_policy(context_like auto &ctx, Fn &&fn) {
+            using C = std::remove_reference_t<decltype(ctx)>;
+            if constexpr (C::policy.fixed) {
+                fn(ctx);
+            } else {
+                auto run = [&]<errors::error_policy Level>() {
+                    fixed_scope<C, Level> scope(ctx);
+                    fn(scope.get());
+                };
+                switch (ctx.sf.policy) {
+                    case errors::error_policy::STRICT: return run.template operator()<errors::error_policy::STRICT>();
+                    case errors::error_policy::IGNORE: return run.template operator()<errors::error_policy::IGNORE>();
+                    default: return run.template operator()<errors::error_policy::MEDIUM>();
+                }
+            }
+        }
+    }
+
+    // === Result ==============================================================
+    // 结果
+    template<typename T>
+    class result {
+    public:
+        result(T value) : v_(std::in_place_index<0>, std::move(value)) {
+        }
+
+        result(const errors::code c) : v_(std::in_place_index<1>, c) {
+        }
+
+        [[nodiscard]] bool has_value() const { return v_.index() == 0; }
+        explicit operator bool() const { return has_value(); }
+
+        // Only meaningful without a value
+        [[nodiscard]] errors::code error() const { return *std::get_if<1>(&v_); }
+
+        [[nodiscard]] T &value() & { return check(), *std::get_if<0>(&v_); }
+        [[nodiscard]] const T &value() const & { return check(), *std::get_if<0>(&v_); }
+        [[nodiscard]] T &&value() && { return check(), std::move(*std::get_if<0>(&v_)); }
+
+        [[nodiscard]] T value_or(T other) const & { return has_value() ? *std::get_if<0>(&v_) : std::move(other); }
+
+        T &operator*() & { return *std::get_if<0>(&v_); }
+        const T &operator*() const & { return *std::get_if<0>(&v_); }
+        T &&operator*() && { return std::move(*std::get_if<0>(&v_)); }
+        T *operator->() { return std::get_if<0>(&v_); }
+        const T *operator->() const { return std::get_if<0>(&v_); }
+
+    private:
+        std::variant<T, errors::code> v_;
+
+        void check() const {
+            if (!has_value())
+                BSP_THROW(errors::make(error(), "result holds no value"));
+        }
+    };
+
+    template<>
+    class result<void> {
+    public:
+        result() = default;
+
+        result(const errors::code c) : error_(c) {
+        }
+
+        [[nodiscard]] bool has_value() const { return !error_.has_value(); }
+        explicit operator bool() const { return has_value(); }
+
+        // Only meaningful without a value
+        [[nodiscard]] errors::code error() const { return *error_; }
+
+        void value() const {
+            if (error_)
+                BSP_THROW(errors::make(*error_, "result holds no value"));
+        }
+
+    private:
+        std::optional<errors::code> error_;
+    };
+
+    // === RAII Guards =========================================================
+    // RAII 限制工具
+    template<policy P>
+    template<bool GetDeeper, bool RollbackSafety, bool RollbackOpts, errors::trace_frame_generator FrameFn>
+    struct basic_context<P>::scope_guard {
+        const std::reference_wrapper<basic_context> ctx;
+        [[no_unique_address, maybe_unused]] FrameFn traceback_frame_fn;
+
+    private:
+        [[maybe_unused]] safety origin_sf;
+        [[maybe_unused]] option origin_opt;
+        [[maybe_unused]] size_t origin_depth;
+        [[maybe_unused]] int uncaught_exceptions;
+
+    public:
+        explicit scope_guard(basic_context &ctx,
+                             FrameFn &&frame_fn) : ctx(ctx),
+                                                   traceback_frame_fn(std::forward<FrameFn>(frame_fn)) {
+            if constexpr (GetDeeper && P.limits) {
+                if (ctx.st.current_depth + 1 > ctx.sf.max_depth)
+                    detail::fail(ctx, errors::code::depth_limit_exceeded,
+                                 [&] { return errors::depth_limit_exceeded(ctx.sf.max_depth, ctx); });
+                origin_depth = ctx.st.current_depth;
+                ctx.st.current_depth++;
+            }
+
+            if constexpr (RollbackSafety) {
+                origin_sf = ctx.sf;
+            }
+
+            if constexpr (RollbackOpts) {
+                origin_opt = ctx.opt;
+            }
+
+            if constexpr (P.traceback) {
+                uncaught_exceptions = std::uncaught_exceptions();
+            }
+        }
+
+        ~scope_guard() {
+            if constexpr (GetDeeper && P.limits) ctx.get().st.current_depth = origin_depth;
+            if constexpr (RollbackSafety) ctx.get().sf = origin_sf;
+            if constexpr (RollbackOpts) ctx.get().opt = origin_opt;
+            if constexpr (P.traceback)
+                if (std::uncaught_exceptions() > uncaught_exceptions) {
+                    BSP_TRY {
+                        ctx.get().get_traceback().push(traceback_frame_fn());
+                    } BSP_CATCH_ALL {
+                        ctx.get().get_traceback().push(errors::wrapper_frame{
+                            "[!!] error when generating traceback info"
+                        });
+                    }
+                }
+        }
+
+        scope_guard(const scope_guard &) = delete;
+
+        scope_guard &operator=(const scope_guard &) = delete;
+    };
+
+    // Usage:
+    // auto g = ctx.template guard<G, R>([&] { return traceback_frame; });
+    // Set G to true when the serializer is a container
+    // Set R to true when the serializer may modify the options
+    //
+    // The compiler will optimize it, so the lambda function won't cause runtime cost.
     // Please enable O2 optimization
+    template<policy P>
     template<bool GetDeeper, bool RollbackSafety, bool RollbackOpts, errors::trace_frame_generator FrameFn>
-    context::scope_guard<GetDeeper, RollbackSafety, RollbackOpts, FrameFn> context::guard(FrameFn &&frame_fn) {
+    auto basic_context<P>::guard(FrameFn &&frame_fn) -> scope_guard<GetDeeper, RollbackSafety, RollbackOpts, FrameFn> {
         return scope_guard<GetDeeper, RollbackSafety, RollbackOpts, std::decay_t<FrameFn> >(
             *this, std::forward<FrameFn>(frame_fn));
     }
 
+    // Usage:
+    // ctx.leaf([] { return traceback_frame; }, [&] { ... });
+    // For values without children that change no options, in place of guard<false, false, false>.
+    // The frame is recorded by a catch handler, so nothing runs on success (a guard queries
+    // std::uncaught_exceptions() when it is created and destroyed).
+    template<policy P>
+    template<errors::trace_frame_generator FrameFn, typename Body>
+    void basic_context<P>::leaf(FrameFn &&frame_fn, Body &&body) {
+        if constexpr (P.traceback) {
+            BSP_TRY {
+                body();
+            } BSP_CATCH_ALL {
+                BSP_TRY {
+                    get_traceback().push(frame_fn());
+                } BSP_CATCH_ALL {
+                    get_traceback().push(errors::wrapper_frame{
+                        "[!!] error when generating traceback info"
+                    });
+                }
+                BSP_RETHROW;
+            }
+        } else {
+            body();
+        }
+    }
+
 
     /* =========================================================================
      * Class Definitions
@@ -717,21 +1430,21 @@ namespace bsp {
             void read_bytes(uint8_t *buf, const std::streamsize n) const {
                 is.read(reinterpret_cast<char *>(buf), n);
                 if (is.eof())
-                    throw errors::unexpected_eof(
+                    BSP_THROW(errors::unexpected_eof(
                         static_cast<size_t>(n),
                         static_cast<size_t>(is.gcount()),
                         "std::istream"
-                    );
+                    ));
                 if (is.fail())
-                    throw errors::error(errors::code::runtime_error, "error when reading std::istream");
+                    BSP_THROW(errors::error(errors::code::runtime_error, "error when reading std::istream"));
             }
 
             [[nodiscard]] uint8_t read_byte() const {
                 char c;
                 if (!is.get(c)) {
                     if (is.eof())
-                        throw errors::unexpected_eof(1, 0, "std::istream");
-                    throw errors::error(errors::code::runtime_error, "error when reading std::istream");
+                        BSP_THROW(errors::unexpected_eof(1, 0, "std::istream"));
+                    BSP_THROW(errors::error(errors::code::runtime_error, "error when reading std::istream"));
                 }
                 return static_cast<uint8_t>(c);
             }
@@ -746,20 +1459,20 @@ namespace bsp {
             void write_bytes(const uint8_t *buf, const std::streamsize n) const {
                 os.write(reinterpret_cast<const char *>(buf), n);
                 if (os.eof())
-                    throw errors::unexpected_eof(
+                    BSP_THROW(errors::unexpected_eof(
                         static_cast<size_t>(n),
                         0,
                         "std::ostream"
-                    );
+                    ));
                 if (os.fail())
-                    throw errors::error(errors::code::runtime_error, "error when writing to std::ostream");
+                    BSP_THROW(errors::error(errors::code::runtime_error, "error when writing to std::ostream"));
             }
 
             void write_byte(const uint8_t b) const {
                 if (!os.put(static_cast<char>(b))) {
                     if (os.eof())
-                        throw errors::unexpected_eof(1, 0, "std::ostream");
-                    throw errors::error(errors::code::runtime_error, "error when writing to std::ostream");
+                        BSP_THROW(errors::unexpected_eof(1, 0, "std::ostream"));
+                    BSP_THROW(errors::error(errors::code::runtime_error, "error when writing to std::ostream"));
                 }
             }
         };
@@ -777,20 +1490,30 @@ namespace bsp {
 
             void read_bytes(uint8_t *dst, const std::streamsize n) {
                 if (pos + static_cast<size_t>(n) > buf.size())
-                    throw errors::unexpected_eof(
+                    BSP_THROW(errors::unexpected_eof(
                         static_cast<size_t>(n),
                         buf.size() - pos,
                         "BufferReader"
-                    );
+                    ));
                 memcpy(dst, buf.data() + pos, static_cast<size_t>(n));
                 pos += static_cast<size_t>(n);
             }
 
             [[nodiscard]] uint8_t read_byte() {
                 if (pos >= buf.size())
-                    throw errors::unexpected_eof(1, 0, "BufferReader");
+                    BSP_THROW(errors::unexpected_eof(1, 0, "BufferReader"));
                 return buf[pos++];
             }
+
+            [[nodiscard]] const uint8_t *borrow_bytes(const size_t n) {
+                if (n > buf.size() - pos)
+                    BSP_THROW(errors::unexpected_eof(n, buf.size() - pos, "BufferReader"));
+                const uint8_t *p = buf.data() + pos;
+                pos += n;
+                return p;
+            }
+
+            [[nodiscard]] size_t remaining() const { return buf.size() - pos; }
         };
 
         struct BufferWriter {
@@ -803,6 +1526,12 @@ namespace bsp {
             void write_byte(const uint8_t b) {
                 buf.push_back(b);
             }
+
+            [[nodiscard]] uint8_t *reserve_bytes(const size_t n) {
+                const size_t old_size = buf.size();
+                buf.resize(old_size + n);
+                return buf.data() + old_size;
+            }
         };
 
         struct BytesReader {
@@ -820,20 +1549,362 @@ namespace bsp {
 
             void read_bytes(uint8_t *buf, const std::streamsize n) {
                 if (pos + static_cast<size_t>(n) > size)
-                    throw errors::unexpected_eof(
+                    BSP_THROW(errors::unexpected_eof(
                         static_cast<size_t>(n),
                         size - pos,
                         "BytesReader"
-                    );
+                    ));
                 memcpy(buf, data + pos, static_cast<size_t>(n));
                 pos += static_cast<size_t>(n);
             }
 
             [[nodiscard]] uint8_t read_byte() {
                 if (pos >= size)
-                    throw errors::unexpected_eof(1, 0, "BytesReader");
+                    BSP_THROW(errors::unexpected_eof(1, 0, "BytesReader"));
+                return data[pos++];
+            }
+
+            [[nodiscard]] const uint8_t *borrow_bytes(const size_t n) {
+                if (n > size - pos)
+                    BSP_THROW(errors::unexpected_eof(n, size - pos, "BytesReader"));
+                const uint8_t *p = data + pos;
+                pos += n;
+                return p;
+            }
+
+            [[nodiscard]] size_t remaining() const { return size - pos; }
+        };
+
+
+        // --- Non-Throwing I/O --------------------------------------------------------
+        // 不抛出异常的 I/O 类
+        struct CheckedReader {
+            const uint8_t *data;
+            size_t size;
+            size_t pos = 0;
+            std::optional<errors::code> error; // First failure
+
+            explicit CheckedReader(const std::vector<uint8_t> &buf)
+                : data(buf.data()), size(buf.size()) {
+            }
+
+            CheckedReader(const uint8_t *data_, const size_t size_)
+                : data(data_), size(size_) {
+            }
+
+            void read_bytes(uint8_t *buf, const std::streamsize n) {
+                const auto k = static_cast<size_t>(n);
+                if (error || k > size - pos) {
+                    fail(errors::code::unexpected_eof);
+                    std::fill_n(buf, k, 0);
+                    return;
+                }
+                std::copy_n(data + pos, k, buf);
+                pos += k;
+            }
+
+            [[nodiscard]] uint8_t read_byte() {
+                if (error || pos >= size) {
+                    fail(errors::code::unexpected_eof);
+                    return 0;
+                }
                 return data[pos++];
             }
+
+            // After a failure, points to n zeros
+            [[nodiscard]] const uint8_t *borrow_bytes(const size_t n) {
+                if (error || n > size - pos) {
+                    fail(errors::code::unexpected_eof);
+                    if (zeros_.size() < n) zeros_.resize(n);
+                    return zeros_.data();
+                }
+                const uint8_t *p = data + pos;
+                pos += n;
+                return p;
+            }
+
+            void skip(const size_t n) {
+                if (error || n > size - pos)
+                    fail(errors::code::unexpected_eof);
+                else
+                    pos += n;
+            }
+
+            void fail(const errors::code c) {
+                if (!error) error = c;
+            }
+
+            [[nodiscard]] size_t remaining() const { return size - pos; }
+
+        private:
+            std::vector<uint8_t> zeros_;
+        };
+
+        struct CheckedWriter {
+            uint8_t *data;
+            size_t size;
+            size_t pos = 0;
+            std::optional<errors::code> error; // First failure
+
+            CheckedWriter(uint8_t *data_, const size_t size_) : data(data_), size(size_) {
+            }
+
+            void write_bytes(const uint8_t *buf, const std::streamsize n) {
+                std::copy_n(buf, n, reserve_bytes(static_cast<size_t>(n)));
+            }
+
+            void write_byte(const uint8_t b) {
+                *reserve_bytes(1) = b;
+            }
+
+            // After a failure, points to n bytes of scratch space
+            [[nodiscard]] uint8_t *reserve_bytes(const size_t n) {
+                if (error || n > size - pos) {
+                    fail(errors::code::out_of_space);
+                    if (scratch_.size() < n) scratch_.resize(n);
+                    return scratch_.data();
+                }
+                uint8_t *p = data + pos;
+                pos += n;
+                return p;
+            }
+
+            void fail(const errors::code c) {
+                if (!error) error = c;
+            }
+
+        private:
+            std::vector<uint8_t> scratch_;
+        };
+
+
+        // --- I/O over Byte Segments --------------------------------------------------
+        // 分段字节的 I/O 类
+        struct SegmentedReader {
+            std::span<const std::span<const uint8_t> > segments;
+            size_t segment = 0; // Current segment
+            size_t pos = 0; // Position in the current segment
+
+            explicit SegmentedReader(const std::span<const std::span<const uint8_t> > segments_)
+                : segments(segments_) {
+                skip_empty();
+            }
+
+            void read_bytes(uint8_t *buf, const std::streamsize n) {
+                auto left = static_cast<size_t>(n);
+                while (left) {
+                    if (segment >= segments.size())
+                        BSP_THROW(errors::unexpected_eof(static_cast<size_t>(n), static_cast<size_t>(n) - left,
+                                                         "SegmentedReader"));
+                    const auto &seg = segments[segment];
+                    const size_t k = std::min(left, seg.size() - pos);
+                    memcpy(buf, seg.data() + pos, k);
+                    buf += k;
+                    left -= k;
+                    advance(k);
+                }
+            }
+
+            [[nodiscard]] uint8_t read_byte() {
+                if (segment >= segments.size())
+                    BSP_THROW(errors::unexpected_eof(1, 0, "SegmentedReader"));
+                const uint8_t b = segments[segment][pos];
+                advance(1);
+                return b;
+            }
+
+            // In place within a segment, values crossing a boundary are staged
+            [[nodiscard]] const uint8_t *borrow_bytes(const size_t n) {
+                if (segment < segments.size() && n <= segments[segment].size() - pos) {
+                    const uint8_t *p = segments[segment].data() + pos;
+                    advance(n);
+                    return p;
+                }
+                // Checked first, so an untrusted n is never staged beyond the input
+                if (const size_t left = remaining(); n > left)
+                    BSP_THROW(errors::unexpected_eof(n, left, "SegmentedReader"));
+                staging.resize(n);
+                read_bytes(staging.data(), static_cast<std::streamsize>(n));
+                return staging.data();
+            }
+
+            void skip(const size_t n) {
+                size_t left = n;
+                while (left) {
+                    if (segment >= segments.size())
+                        BSP_THROW(errors::unexpected_eof(n, n - left, "SegmentedReader"));
+                    const size_t k = std::min(left, segments[segment].size() - pos);
+                    left -= k;
+                    advance(k);
+                }
+            }
+
+            // Unread bytes in all segments
+            [[nodiscard]] size_t remaining() const {
+                if (segment >= segments.size()) return 0;
+                size_t total = segments[segment].size() - pos;
+                for (size_t i = segment + 1; i < segments.size(); ++i) total += segments[i].size();
+                return total;
+            }
+
+        private:
+            std::vector<uint8_t> staging;
+
+            void advance(const size_t k) {
+                pos += k;
+                if (pos == segments[segment].size()) {
+                    ++segment;
+                    pos = 0;
+                    skip_empty();
+                }
+            }
+
+            void skip_empty() {
+                while (segment < segments.size() && segments[segment].empty()) ++segment;
+            }
+        };
+
+
+        // --- I/O Counting Bytes ----------------------------------------------------
+        // 计数 I/O 类
+        struct CountingWriter {
+            size_t count = 0;
+
+            void write_bytes(const uint8_t *, const std::streamsize n) {
+                count += static_cast<size_t>(n);
+            }
+
+            void write_byte(const uint8_t) {
+                ++count;
+            }
+        };
+
+        struct SpanWriter {
+            uint8_t *data;
+            size_t size;
+            size_t pos = 0;
+
+            SpanWriter(uint8_t *data_, const size_t size_) : data(data_), size(size_) {
+            }
+
+            void write_bytes(const uint8_t *buf, const std::streamsize n) {
+                memcpy(reserve_bytes(static_cast<size_t>(n)), buf, static_cast<size_t>(n));
+            }
+
+            void write_byte(const uint8_t b) {
+                *reserve_bytes(1) = b;
+            }
+
+            [[nodiscard]] uint8_t *reserve_bytes(const size_t n) {
+                if (n > size - pos)
+                    BSP_THROW(errors::make(
+                        errors::code::fixed_size_mismatch,
+                        detail::concat("writing ", n, " bytes to a SpanWriter remaining ", size - pos, " bytes")
+                    ));
+                uint8_t *p = data + pos;
+                pos += n;
+                return p;
+            }
+        };
+
+        class ScatterWriter {
+        public:
+            // Payloads of at least borrow_threshold bytes are referenced, smaller data is copied into chunks
+            explicit ScatterWriter(const size_t borrow_threshold = 4096, const size_t chunk_size = 16 * 1024)
+                : threshold_(borrow_threshold), chunk_size_(std::max<size_t>(64, chunk_size)) {
+            }
+
+            void write_bytes(const uint8_t *p, const std::streamsize n) {
+                auto left = static_cast<size_t>(n);
+                while (left) {
+                    if (used_ == capacity_) next_chunk(chunk_size_);
+                    const size_t k = std::min(left, capacity_ - used_);
+                    std::memcpy(append_owned(k), p, k);
+                    p += k;
+                    left -= k;
+                }
+            }
+
+            void write_byte(const uint8_t b) {
+                if (used_ == capacity_) next_chunk(chunk_size_);
+                *append_owned(1) = b;
+            }
+
+            [[nodiscard]] uint8_t *reserve_bytes(const size_t n) {
+                if (n > capacity_ - used_) next_chunk(std::max(chunk_size_, n));
+                return append_owned(n);
+            }
+
+            // The memory must stay valid until the segments have been sent
+            void write_borrowed(const uint8_t *p, const size_t n) {
+                if (n < threshold_) {
+                    write_bytes(p, static_cast<std::streamsize>(n));
+                    return;
+                }
+                segments_.emplace_back(p, n);
+                owned_open_ = false;
+                size_ += n;
+            }
+
+            // Output in order, owned chunks and borrowed payloads interleaved
+            [[nodiscard]] const std::vector<std::span<const uint8_t> > &segments() const { return segments_; }
+
+            [[nodiscard]] size_t size() const { return size_; }
+
+            // Copies the whole output into another writer
+            void copy_to(Writer auto &w) const {
+                for (const auto &seg: segments_)
+                    w.write_bytes(seg.data(), static_cast<std::streamsize>(seg.size()));
+            }
+
+            // Forgets the output and borrowed payloads, owned chunks are kept for reuse
+            void clear() {
+                segments_.clear();
+                size_ = 0;
+                next_ = 0;
+                used_ = capacity_ = 0;
+                owned_open_ = false;
+            }
+
+        private:
+            struct chunk {
+                std::unique_ptr<uint8_t[]> data;
+                size_t size;
+            };
+
+            // Moves to the next unused chunk with room for n bytes, allocating one if needed
+            void next_chunk(const size_t n) {
+                while (next_ < chunks_.size() && chunks_[next_].size < n) ++next_;
+                if (next_ == chunks_.size())
+                    chunks_.push_back({std::make_unique_for_overwrite<uint8_t[]>(n), n});
+                current_ = chunks_[next_++].data.get();
+                capacity_ = chunks_[next_ - 1].size;
+                used_ = 0;
+                owned_open_ = false;
+            }
+
+            uint8_t *append_owned(const size_t n) {
+                uint8_t *p = current_ + used_;
+                if (owned_open_)
+                    segments_.back() = {segments_.back().data(), segments_.back().size() + n};
+                else
+                    segments_.emplace_back(p, n);
+                owned_open_ = true;
+                used_ += n;
+                size_ += n;
+                return p;
+            }
+
+            size_t threshold_;
+            size_t chunk_size_;
+            std::vector<chunk> chunks_;
+            size_t next_ = 0;
+            uint8_t *current_ = nullptr;
+            size_t used_ = 0;
+            size_t capacity_ = 0;
+            bool owned_open_ = false; // The last segment is owned and may grow
+            std::vector<std::span<const uint8_t> > segments_;
+            size_t size_ = 0;
         };
 
 
@@ -848,35 +1919,81 @@ namespace bsp {
             LimitedReader(R &r, const size_t n) : base(r), remaining(n) {
             }
 
+            // Past the limit, a fallible base records the failure and serves the zeros
             void read_bytes(uint8_t *buf, const std::streamsize n) {
-                if (static_cast<size_t>(n) > remaining)
-                    throw errors::unexpected_eof(
+                if (static_cast<size_t>(n) > remaining) {
+                    if constexpr (FallibleReader<R>) {
+                        base.fail(errors::code::unexpected_eof);
+                        return base.read_bytes(buf, n);
+                    }
+                    BSP_THROW(errors::unexpected_eof(
                         static_cast<size_t>(n),
                         remaining,
                         "LimitedReader"
-                    );
-                try {
+                    ));
+                }
+                BSP_TRY {
                     base.read_bytes(buf, n);
                     remaining -= static_cast<size_t>(n);
-                } catch (...) {
+                } BSP_CATCH_ALL {
                     io_failed = true;
-                    throw;
+                    BSP_RETHROW;
                 }
             }
 
             [[nodiscard]] uint8_t read_byte() {
-                if (remaining == 0)
-                    throw errors::unexpected_eof(1, 0, "LimitedReader");
-                try {
+                if (remaining == 0) {
+                    if constexpr (FallibleReader<R>) {
+                        base.fail(errors::code::unexpected_eof);
+                        return base.read_byte();
+                    }
+                    BSP_THROW(errors::unexpected_eof(1, 0, "LimitedReader"));
+                }
+                BSP_TRY {
                     const uint8_t b = base.read_byte();
                     --remaining;
                     return b;
-                } catch (...) {
+                } BSP_CATCH_ALL {
+                    io_failed = true;
+                    BSP_RETHROW;
+                }
+            }
+
+            [[nodiscard]] const uint8_t *borrow_bytes(const size_t n) requires ContiguousReader<R> {
+                if (n > remaining) {
+                    if constexpr (FallibleReader<R>) {
+                        base.fail(errors::code::unexpected_eof);
+                        return base.borrow_bytes(n);
+                    }
+                    BSP_THROW(errors::unexpected_eof(n, remaining, "LimitedReader"));
+                }
+                BSP_TRY {
+                    const uint8_t *p = base.borrow_bytes(n);
+                    remaining -= n;
+                    return p;
+                } BSP_CATCH_ALL {
+                    io_failed = true;
+                    BSP_RETHROW;
+                }
+            }
+
+            [[nodiscard]] auto borrow_slice(const size_t n) requires SharingReader<R> {
+                if (n > remaining)
+                    BSP_THROW(errors::unexpected_eof(n, remaining, "LimitedReader"));
+                BSP_TRY {
+                    auto s = base.borrow_slice(n);
+                    remaining -= n;
+                    return s;
+                } BSP_CATCH_ALL {
                     io_failed = true;
-                    throw;
+                    BSP_RETHROW;
                 }
             }
 
+            void fail(const errors::code c) requires FallibleReader<R> {
+                base.fail(c);
+            }
+
             void skip_remaining() {
                 if (io_failed) return;
                 static uint8_t buf[256];
@@ -899,37 +2016,53 @@ namespace bsp {
 
             void write_bytes(const uint8_t *buf, const std::streamsize n) {
                 if (static_cast<size_t>(n) > remaining)
-                    throw errors::make(
+                    BSP_THROW(errors::make(
                         errors::code::fixed_size_mismatch,
                         detail::concat("writing ", n, " bytes to a LimitWriter remaining ", remaining, "bytes")
-                    );
-                try {
+                    ));
+                BSP_TRY {
                     base.write_bytes(buf, n);
                     remaining -= static_cast<size_t>(n);
-                } catch (...) {
+                } BSP_CATCH_ALL {
                     io_failed = true;
-                    throw;
+                    BSP_RETHROW;
                 }
             }
 
             void write_byte(const uint8_t b) {
                 if (remaining == 0)
-                    throw errors::make(
+                    BSP_THROW(errors::make(
                         errors::code::fixed_size_mismatch,
                         "writing 1 byte to a LimitedWriter remaining 0 byte"
-                    );
-                try {
+                    ));
+                BSP_TRY {
                     base.write_byte(b);
                     --remaining;
-                } catch (...) {
+                } BSP_CATCH_ALL {
                     io_failed = true;
-                    throw;
+                    BSP_RETHROW;
                 }
             }
 
-            void pad_zero() {
-                if (io_failed) return;
-                static uint8_t buf[256] = {};
+            [[nodiscard]] uint8_t *reserve_bytes(const size_t n) requires ContiguousWriter<W> {
+                if (n > remaining)
+                    BSP_THROW(errors::make(
+                        errors::code::fixed_size_mismatch,
+                        detail::concat("writing ", n, " bytes to a LimitWriter remaining ", remaining, "bytes")
+                    ));
+                BSP_TRY {
+                    uint8_t *p = base.reserve_bytes(n);
+                    remaining -= n;
+                    return p;
+                } BSP_CATCH_ALL {
+                    io_failed = true;
+                    BSP_RETHROW;
+                }
+            }
+
+            void pad_zero() {
+                if (io_failed) return;
+                static uint8_t buf[256] = {};
                 while (remaining) {
                     const size_t k = std::min(remaining, static_cast<size_t>(256));
                     base.write_bytes(buf, k);
@@ -1062,6 +2195,828 @@ namespace bsp {
         };
     }
 
+    // === Thread Pool =========================================================
+    // 线程池
+    namespace parallel {
+        class thread_pool {
+        public:
+            explicit thread_pool(const size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+                workers_.reserve(threads);
+                for (size_t i = 0; i < threads; ++i)
+                    workers_.emplace_back([this] { work(); });
+            }
+
+            ~thread_pool() {
+                {
+                    std::lock_guard lock(mutex_);
+                    stop_ = true;
+                }
+                cv_.notify_all();
+                for (auto &t: workers_) t.join();
+            }
+
+            thread_pool(const thread_pool &) = delete;
+
+            thread_pool &operator=(const thread_pool &) = delete;
+
+            [[nodiscard]] size_t size() const { return workers_.size(); }
+
+            // Runs fn(i) (or fn(i, participant)) for every i in [0, n) and returns when all calls are done.
+            // Participants are the calling thread (0) and up to size() workers, each starts with a slice of
+            // [0, n) and steals half of another slice when its own runs out.
+            // The calling thread takes part, so nested calls from inside fn cannot deadlock.
+            // If calls throw, the exception of the lowest index is rethrown.
+            template<typename Fn>
+            void parallel_for(const size_t n, Fn &&fn) {
+                if (n == 0) return;
+
+                struct slice {
+                    std::mutex m;
+                    size_t begin = 0;
+                    size_t end = 0;
+                };
+                // Helpers may start after the call returned, they only touch the shared state then
+                struct state {
+                    size_t parts;
+                    std::unique_ptr<slice[]> slices;
+                    std::atomic<size_t> joined{0};
+                    size_t done = 0;
+                    std::mutex m;
+                    std::condition_variable cv;
+                };
+                auto st = std::make_shared<state>();
+                st->parts = std::min(n, workers_.size() + 1);
+                st->slices = std::make_unique<slice[]>(st->parts);
+                for (size_t p = 0; p < st->parts; ++p) {
+                    st->slices[p].begin = n * p / st->parts;
+                    st->slices[p].end = n * (p + 1) / st->parts;
+                }
+                std::vector<std::exception_ptr> errors(n);
+
+                auto run = [st, n, &fn, &errors] {
+                    const size_t p = st->joined.fetch_add(1, std::memory_order_relaxed);
+                    if (p >= st->parts) return;
+
+                    slice &own = st->slices[p];
+                    size_t finished = 0;
+                    while (true) {
+                        size_t begin = 0, end = 0;
+                        {
+                            std::lock_guard lock(own.m);
+                            if (own.begin != own.end) {
+                                begin = own.begin;
+                                end = std::min(own.end, begin + std::clamp<size_t>((own.end - begin) / 4, 1, 64));
+                                own.begin = end;
+                            }
+                        }
+
+                        if (begin == end) {
+                            // Steal the back half of the first non-empty slice
+                            for (size_t k = 1; k < st->parts && begin == end; ++k) {
+                                slice &victim = st->slices[(p + k) % st->parts];
+                                std::lock_guard lock(victim.m);
+                                if (victim.begin != victim.end) {
+                                    begin = victim.begin + (victim.end - victim.begin) / 2;
+                                    end = victim.end;
+                                    victim.end = begin;
+                                }
+                            }
+                            if (begin == end) break;
+
+                            std::lock_guard lock(own.m);
+                            own.begin = begin;
+                            own.end = end;
+                            continue;
+                        }
+
+                        for (size_t i = begin; i < end; ++i) {
+                            BSP_TRY {
+                                if constexpr (std::is_invocable_v<Fn &, size_t, size_t>)
+                                    fn(i, p);
+                                else
+                                    fn(i);
+                            } BSP_CATCH_ALL {
+                                errors[i] = std::current_exception();
+                            }
+                        }
+                        finished += end - begin;
+                    }
+
+                    if (finished) {
+                        std::lock_guard lock(st->m);
+                        if ((st->done += finished) == n) st->cv.notify_all();
+                    }
+                };
+
+                const size_t helpers = st->parts - 1;
+                if (helpers) {
+                    {
+                        std::lock_guard lock(mutex_);
+                        for (size_t i = 0; i < helpers; ++i) queue_.emplace_back(run);
+                    }
+                    cv_.notify_all();
+                }
+                run();
+
+                {
+                    std::unique_lock lock(st->m);
+                    st->cv.wait(lock, [&] { return st->done == n; });
+                }
+                for (auto &e: errors)
+                    if (e) std::rethrow_exception(e);
+            }
+
+        private:
+            std::vector<std::thread> workers_;
+            std::deque<std::function<void()> > queue_;
+            std::mutex mutex_;
+            std::condition_variable cv_;
+            bool stop_ = false;
+
+            void work() {
+                while (true) {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock lock(mutex_);
+                        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                        if (queue_.empty()) return;
+                        job = std::move(queue_.front());
+                        queue_.pop_front();
+                    }
+                    job();
+                }
+            }
+        };
+    }
+
+
+    // === Async I/O ===========================================================
+    // 异步 I/O
+#ifdef BSP_POSIX
+    namespace detail {
+        // Writes all n bytes, retrying on EINTR and short writes
+        inline void write_fd_all(const int fd, const uint8_t *p, size_t n) {
+            while (n) {
+                const ssize_t k = ::write(fd, p, n);
+                if (k < 0) {
+                    if (errno == EINTR) continue;
+                    BSP_THROW(errors::error(errors::code::runtime_error,
+                                            detail::concat("error when writing to fd ", fd, ": ",
+                                                           std::string(std::strerror(errno)))));
+                }
+                p += k;
+                n -= static_cast<size_t>(k);
+            }
+        }
+
+        // Reads up to n bytes, retrying on EINTR. Returns 0 at the end of the input.
+        [[nodiscard]] inline size_t read_fd_some(const int fd, uint8_t *p, const size_t n) {
+            while (true) {
+                const ssize_t k = ::read(fd, p, n);
+                if (k >= 0) return static_cast<size_t>(k);
+                if (errno != EINTR)
+                    BSP_THROW(errors::error(errors::code::runtime_error,
+                                            detail::concat("error when reading fd ", fd, ": ",
+                                                           std::string(std::strerror(errno)))));
+            }
+        }
+    }
+#endif
+
+    namespace io {
+        // Buffer ring shared by the background I/O classes
+        struct AsyncConfig {
+            size_t buffers = 2; // At least 2: one in use by the caller, the others in flight
+            size_t buffer_size = 1024 * 1024;
+        };
+
+        class AsyncWriter {
+        public:
+            explicit AsyncWriter(std::ostream &os, const AsyncConfig cfg = {})
+                : AsyncWriter(cfg, [&os](const uint8_t *p, const size_t n) {
+                                  os.write(reinterpret_cast<const char *>(p), static_cast<std::streamsize>(n));
+                                  if (os.fail())
+                                      BSP_THROW(errors::error(errors::code::runtime_error,
+                                                              "error when writing to std::ostream"));
+                              },
+                              [&os] {
+                                  if (!os.flush())
+                                      BSP_THROW(errors::error(errors::code::runtime_error,
+                                                              "error when flushing std::ostream"));
+                              }) {
+            }
+
+#ifdef BSP_POSIX
+            // The descriptor stays owned by the caller
+            explicit AsyncWriter(const int fd, const AsyncConfig cfg = {})
+                : AsyncWriter(cfg, [fd](const uint8_t *p, const size_t n) { detail::write_fd_all(fd, p, n); }, [] {}) {
+            }
+#endif
+
+            ~AsyncWriter() {
+                BSP_TRY {
+                    close();
+                } BSP_CATCH_ALL {
+                }
+            }
+
+            AsyncWriter(const AsyncWriter &) = delete;
+
+            AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+            void write_bytes(const uint8_t *buf, const std::streamsize n) {
+                check_open();
+                size_t left = static_cast<size_t>(n);
+                while (left) {
+                    if (current_->size == current_->capacity) hand_off();
+                    const size_t k = std::min(left, current_->capacity - current_->size);
+                    memcpy(current_->data.get() + current_->size, buf, k);
+                    current_->size += k;
+                    buf += k;
+                    left -= k;
+                }
+            }
+
+            void write_byte(const uint8_t b) {
+                check_open();
+                if (current_->size == current_->capacity) hand_off();
+                current_->data[current_->size++] = b;
+            }
+
+            // Values larger than a buffer grow the current buffer instead of being split
+            [[nodiscard]] uint8_t *reserve_bytes(const size_t n) {
+                check_open();
+                if (n > current_->capacity - current_->size) {
+                    if (current_->size) hand_off();
+                    if (n > current_->capacity) current_->grow(n);
+                }
+                uint8_t *p = current_->data.get() + current_->size;
+                current_->size += n;
+                return p;
+            }
+
+            // Hands off the current buffer and waits until everything is written.
+            // Rethrows the first I/O error raised since the last flush.
+            void flush() {
+                if (closed_) return;
+                if (current_->size) hand_off();
+                {
+                    std::unique_lock lock(mutex_);
+                    idle_cv_.wait(lock, [&] { return filled_.empty() && !busy_; });
+                }
+                rethrow_error();
+                sink_flush_();
+            }
+
+            // Flushes and stops the background thread. Later calls do nothing.
+            void close() {
+                if (closed_) return;
+                std::exception_ptr e;
+                BSP_TRY {
+                    flush();
+                } BSP_CATCH_ALL {
+                    e = std::current_exception();
+                }
+                {
+                    std::lock_guard lock(mutex_);
+                    stop_ = true;
+                }
+                work_cv_.notify_one();
+                worker_.join();
+                closed_ = true;
+                if (e) std::rethrow_exception(e);
+            }
+
+        private:
+            struct block {
+                std::unique_ptr<uint8_t[]> data;
+                size_t capacity = 0;
+                size_t size = 0;
+
+                explicit block(const size_t n) : data(std::make_unique_for_overwrite<uint8_t[]>(n)), capacity(n) {
+                }
+
+                void grow(const size_t n) {
+                    auto bigger = std::make_unique_for_overwrite<uint8_t[]>(n);
+                    memcpy(bigger.get(), data.get(), size);
+                    data = std::move(bigger);
+                    capacity = n;
+                }
+            };
+
+            using sink_fn = std::function<void(const uint8_t *, size_t)>;
+
+            AsyncWriter(const AsyncConfig cfg, sink_fn sink, std::function<void()> sink_flush)
+                : sink_(std::move(sink)), sink_flush_(std::move(sink_flush)) {
+                const size_t count = std::max<size_t>(2, cfg.buffers);
+                const size_t size = std::max<size_t>(1, cfg.buffer_size);
+                blocks_.reserve(count);
+                for (size_t i = 0; i < count; ++i) blocks_.emplace_back(size);
+                for (size_t i = 1; i < count; ++i) free_.push_back(&blocks_[i]);
+                current_ = &blocks_[0];
+                worker_ = std::thread([this] { work(); });
+            }
+
+            // Bytes written after close() would never reach the sink
+            void check_open() const {
+                if (closed_) BSP_THROW(errors::error(errors::code::runtime_error, "writing to a closed AsyncWriter"));
+            }
+
+            // Queues the current buffer and takes a free one, waiting while all buffers are in flight
+            void hand_off() {
+                {
+                    std::unique_lock lock(mutex_);
+                    filled_.push_back(current_);
+                    work_cv_.notify_one();
+                    free_cv_.wait(lock, [&] { return !free_.empty(); });
+                    current_ = free_.front();
+                    free_.pop_front();
+                }
+                current_->size = 0;
+                rethrow_error();
+            }
+
+            void rethrow_error() {
+                std::exception_ptr e;
+                {
+                    std::lock_guard lock(mutex_);
+                    e = std::exchange(error_, nullptr);
+                }
+                if (e) std::rethrow_exception(e);
+            }
+
+            void work() {
+                std::unique_lock lock(mutex_);
+                while (true) {
+                    work_cv_.wait(lock, [&] { return stop_ || !filled_.empty(); });
+                    if (filled_.empty()) return;
+
+                    block *b = filled_.front();
+                    filled_.pop_front();
+                    busy_ = true;
+                    const bool failed = error_ != nullptr;
+                    lock.unlock();
+
+                    // After an error, buffers are dropped until the error is reported
+                    std::exception_ptr e;
+                    if (!failed) {
+                        BSP_TRY {
+                            sink_(b->data.get(), b->size);
+                        } BSP_CATCH_ALL {
+                            e = std::current_exception();
+                        }
+                    }
+
+                    lock.lock();
+                    if (e && !error_) error_ = e;
+                    busy_ = false;
+                    free_.push_back(b);
+                    free_cv_.notify_one();
+                    if (filled_.empty()) idle_cv_.notify_all();
+                }
+            }
+
+            sink_fn sink_;
+            std::function<void()> sink_flush_;
+
+            std::vector<block> blocks_;
+            block *current_ = nullptr;
+            std::deque<block *> free_;
+            std::deque<block *> filled_;
+
+            std::mutex mutex_;
+            std::condition_variable work_cv_;
+            std::condition_variable free_cv_;
+            std::condition_variable idle_cv_;
+            bool busy_ = false;
+            bool stop_ = false;
+            bool closed_ = false;
+            std::exception_ptr error_;
+            std::thread worker_;
+        };
+
+        class PrefetchReader {
+        public:
+            explicit PrefetchReader(std::istream &is, const AsyncConfig cfg = {})
+                : PrefetchReader(cfg, [&is](uint8_t *p, const size_t n) -> size_t {
+                    is.read(reinterpret_cast<char *>(p), static_cast<std::streamsize>(n));
+                    if (is.bad())
+                        BSP_THROW(errors::error(errors::code::runtime_error, "error when reading std::istream"));
+                    return static_cast<size_t>(is.gcount());
+                }) {
+            }
+
+#ifdef BSP_POSIX
+            // The descriptor stays owned by the caller
+            explicit PrefetchReader(const int fd, const AsyncConfig cfg = {})
+                : PrefetchReader(cfg, [fd](uint8_t *p, const size_t n) { return detail::read_fd_some(fd, p, n); }) {
+            }
+#endif
+
+            // Waits for a read in progress to return
+            ~PrefetchReader() {
+                {
+                    std::lock_guard lock(mutex_);
+                    stop_ = true;
+                }
+                free_cv_.notify_one();
+                worker_.join();
+            }
+
+            PrefetchReader(const PrefetchReader &) = delete;
+
+            PrefetchReader &operator=(const PrefetchReader &) = delete;
+
+            void read_bytes(uint8_t *buf, const std::streamsize n) {
+                size_t left = static_cast<size_t>(n);
+                while (left) {
+                    if (pos_ == size_ && !next_block())
+                        BSP_THROW(errors::unexpected_eof(static_cast<size_t>(n), static_cast<size_t>(n) - left,
+                                                         "PrefetchReader"));
+                    const size_t k = std::min(left, size_ - pos_);
+                    memcpy(buf, current_->data.get() + pos_, k);
+                    pos_ += k;
+                    buf += k;
+                    left -= k;
+                }
+            }
+
+            [[nodiscard]] uint8_t read_byte() {
+                if (pos_ == size_ && !next_block())
+                    BSP_THROW(errors::unexpected_eof(1, 0, "PrefetchReader"));
+                return current_->data[pos_++];
+            }
+
+            // Values crossing a buffer boundary are staged in a separate buffer.
+            // It grows as blocks are copied, so an untrusted n is never staged beyond the input.
+            [[nodiscard]] const uint8_t *borrow_bytes(const size_t n) {
+                if (n <= size_ - pos_) {
+                    const uint8_t *p = current_->data.get() + pos_;
+                    pos_ += n;
+                    return p;
+                }
+                staging_.clear();
+                size_t left = n;
+                while (left) {
+                    if (pos_ == size_ && !next_block())
+                        BSP_THROW(errors::unexpected_eof(n, n - left, "PrefetchReader"));
+                    const size_t k = std::min(left, size_ - pos_);
+                    const uint8_t *p = current_->data.get() + pos_;
+                    staging_.insert(staging_.end(), p, p + k);
+                    pos_ += k;
+                    left -= k;
+                }
+                return staging_.data();
+            }
+
+            // Discards n bytes block by block
+            void skip(const size_t n) {
+                size_t left = n;
+                while (left) {
+                    if (pos_ == size_ && !next_block())
+                        BSP_THROW(errors::unexpected_eof(n, n - left, "PrefetchReader"));
+                    const size_t k = std::min(left, size_ - pos_);
+                    pos_ += k;
+                    left -= k;
+                }
+            }
+
+        private:
+            struct block {
+                std::unique_ptr<uint8_t[]> data;
+                size_t capacity = 0;
+                size_t size = 0;
+
+                explicit block(const size_t n) : data(std::make_unique_for_overwrite<uint8_t[]>(n)), capacity(n) {
+                }
+            };
+
+            using source_fn = std::function<size_t(uint8_t *, size_t)>;
+
+            PrefetchReader(const AsyncConfig cfg, source_fn source) : source_(std::move(source)) {
+                const size_t count = std::max<size_t>(2, cfg.buffers);
+                const size_t size = std::max<size_t>(1, cfg.buffer_size);
+                blocks_.reserve(count);
+                for (size_t i = 0; i < count; ++i) {
+                    blocks_.emplace_back(size);
+                    free_.push_back(&blocks_[i]);
+                }
+                worker_ = std::thread([this] { work(); });
+            }
+
+            // Returns the drained buffer and takes the next filled one. False at the end of the input.
+            bool next_block() {
+                std::unique_lock lock(mutex_);
+                if (current_) {
+                    free_.push_back(std::exchange(current_, nullptr));
+                    free_cv_.notify_one();
+                }
+                pos_ = size_ = 0;
+                filled_cv_.wait(lock, [&] { return !filled_.empty() || done_; });
+                if (filled_.empty()) {
+                    if (error_) std::rethrow_exception(error_);
+                    return false;
+                }
+                current_ = filled_.front();
+                filled_.pop_front();
+                size_ = current_->size;
+                return true;
+            }
+
+            void work() {
+                std::unique_lock lock(mutex_);
+                while (true) {
+                    free_cv_.wait(lock, [&] { return stop_ || !free_.empty(); });
+                    if (stop_) return;
+
+                    block *b = free_.front();
+                    free_.pop_front();
+                    lock.unlock();
+
+                    // Fill the whole buffer so the decoding thread switches buffers as rarely as possible
+                    b->size = 0;
+                    bool end = false;
+                    std::exception_ptr e;
+                    BSP_TRY {
+                        while (b->size < b->capacity) {
+                            const size_t k = source_(b->data.get() + b->size, b->capacity - b->size);
+                            if (k == 0) {
+                                end = true;
+                                break;
+                            }
+                            b->size += k;
+                        }
+                    } BSP_CATCH_ALL {
+                        e = std::current_exception();
+                        end = true;
+                    }
+
+                    lock.lock();
+                    if (b->size) filled_.push_back(b);
+                    else free_.push_back(b);
+                    if (end) {
+                        error_ = e;
+                        done_ = true;
+                    }
+                    filled_cv_.notify_one();
+                    if (end) return;
+                }
+            }
+
+            source_fn source_;
+
+            std::vector<block> blocks_;
+            block *current_ = nullptr;
+            size_t pos_ = 0;
+            size_t size_ = 0;
+            std::vector<uint8_t> staging_;
+
+            std::deque<block *> free_;
+            std::deque<block *> filled_;
+
+            std::mutex mutex_;
+            std::condition_variable free_cv_;
+            std::condition_variable filled_cv_;
+            bool stop_ = false;
+            bool done_ = false;
+            std::exception_ptr error_;
+            std::thread worker_;
+        };
+    }
+
+
+    // === File Descriptor I/O =================================================
+    // 文件描述符 I/O
+#ifdef BSP_POSIX
+    namespace detail {
+        // Writes every iovec entry, retrying on EINTR and resuming after short writes
+        inline void writev_all(const int fd, iovec *iov, int count) {
+            while (count) {
+                const ssize_t k = ::writev(fd, iov, std::min(count, IOV_MAX));
+                if (k < 0) {
+                    if (errno == EINTR) continue;
+                    BSP_THROW(errors::error(errors::code::runtime_error,
+                                            detail::concat("error when writing to fd ", fd, ": ",
+                                                           std::string(std::strerror(errno)))));
+                }
+                auto done = static_cast<size_t>(k);
+                while (count && done >= iov->iov_len) {
+                    done -= iov->iov_len;
+                    ++iov;
+                    --count;
+                }
+                if (count) {
+                    iov->iov_base = static_cast<uint8_t *>(iov->iov_base) + done;
+                    iov->iov_len -= done;
+                }
+            }
+        }
+    }
+
+    namespace io {
+        class FdWriter {
+        public:
+            // The descriptor stays owned by the caller
+            explicit FdWriter(const int fd, const size_t buffer_size = 64 * 1024)
+                : fd_(fd), capacity_(std::max<size_t>(64, buffer_size)),
+                  buf_(std::make_unique_for_overwrite<uint8_t[]>(capacity_)) {
+            }
+
+            // Flushes and ignores errors, call flush() to see them
+            ~FdWriter() {
+                BSP_TRY {
+                    flush();
+                } BSP_CATCH_ALL {
+                }
+            }
+
+            FdWriter(const FdWriter &) = delete;
+
+            FdWriter &operator=(const FdWriter &) = delete;
+
+            void write_bytes(const uint8_t *p, const std::streamsize n) {
+                const auto len = static_cast<size_t>(n);
+                if (len <= capacity_ - size_) {
+                    std::memcpy(buf_.get() + size_, p, len);
+                    size_ += len;
+                } else if (len >= capacity_ / 2) {
+                    iovec iov[2] = {{buf_.get(), size_}, {const_cast<uint8_t *>(p), len}};
+                    size_ = 0;
+                    detail::writev_all(fd_, iov, 2);
+                } else {
+                    flush();
+                    std::memcpy(buf_.get(), p, len);
+                    size_ = len;
+                }
+            }
+
+            void write_byte(const uint8_t b) {
+                if (size_ == capacity_) flush();
+                buf_[size_++] = b;
+            }
+
+            [[nodiscard]] uint8_t *reserve_bytes(const size_t n) {
+                if (n > capacity_ - size_) {
+                    flush();
+                    if (n > capacity_) {
+                        capacity_ = n;
+                        buf_ = std::make_unique_for_overwrite<uint8_t[]>(capacity_);
+                    }
+                }
+                uint8_t *p = buf_.get() + size_;
+                size_ += n;
+                return p;
+            }
+
+            // Sends the buffered bytes followed by the given payloads in one writev, without copying them
+            void write_vectored(const std::span<const std::span<const uint8_t> > payloads) {
+                std::vector<iovec> iov;
+                iov.reserve(payloads.size() + 1);
+                if (size_) iov.push_back({buf_.get(), size_});
+                for (const auto &p: payloads)
+                    if (!p.empty()) iov.push_back({const_cast<uint8_t *>(p.data()), p.size()});
+                size_ = 0;
+                detail::writev_all(fd_, iov.data(), static_cast<int>(iov.size()));
+            }
+
+            void flush() {
+                if (!size_) return;
+                const size_t n = std::exchange(size_, 0);
+                detail::write_fd_all(fd_, buf_.get(), n);
+            }
+
+            [[nodiscard]] int fd() const { return fd_; }
+
+        private:
+            int fd_;
+            size_t capacity_;
+            std::unique_ptr<uint8_t[]> buf_;
+            size_t size_ = 0;
+        };
+
+        class FdReader {
+        public:
+            // The descriptor stays owned by the caller
+            explicit FdReader(const int fd, const size_t buffer_size = 64 * 1024)
+                : fd_(fd), base_capacity_(std::max<size_t>(64, buffer_size)), capacity_(base_capacity_),
+                  buf_(std::make_unique_for_overwrite<uint8_t[]>(capacity_)) {
+            }
+
+            FdReader(const FdReader &) = delete;
+
+            FdReader &operator=(const FdReader &) = delete;
+
+            void read_bytes(uint8_t *dst, const std::streamsize n) {
+                auto left = static_cast<size_t>(n);
+                const size_t k = std::min(left, end_ - pos_);
+                std::memcpy(dst, buf_.get() + pos_, k);
+                pos_ += k;
+                dst += k;
+                left -= k;
+
+                // The buffer is empty now: read the rest directly and refill the buffer in the same call
+                while (left) {
+                    iovec iov[2] = {{dst, left}, {buf_.get(), capacity_}};
+                    const size_t got = readv_some(iov, 2);
+                    if (got == 0)
+                        BSP_THROW(errors::unexpected_eof(static_cast<size_t>(n), static_cast<size_t>(n) - left,
+                                                         "FdReader"));
+                    const size_t direct = std::min(got, left);
+                    dst += direct;
+                    left -= direct;
+                    pos_ = 0;
+                    end_ = got - direct;
+                }
+            }
+
+            [[nodiscard]] uint8_t read_byte() {
+                if (pos_ == end_ && !fill(1))
+                    BSP_THROW(errors::unexpected_eof(1, 0, "FdReader"));
+                return buf_[pos_++];
+            }
+
+            [[nodiscard]] const uint8_t *borrow_bytes(const size_t n) {
+                if (n > end_ - pos_ && !fill(n))
+                    BSP_THROW(errors::unexpected_eof(n, end_ - pos_, "FdReader"));
+                const uint8_t *p = buf_.get() + pos_;
+                pos_ += n;
+                return p;
+            }
+
+            // Discards n bytes, reading them in buffer-sized steps
+            void skip(const size_t n) {
+                size_t left = n;
+                const size_t k = std::min(left, end_ - pos_);
+                pos_ += k;
+                left -= k;
+                while (left) {
+                    iovec iov{buf_.get(), capacity_};
+                    const size_t got = readv_some(&iov, 1);
+                    if (got == 0)
+                        BSP_THROW(errors::unexpected_eof(n, n - left, "FdReader"));
+                    pos_ = std::min(got, left);
+                    end_ = got;
+                    left -= pos_;
+                }
+            }
+
+            [[nodiscard]] int fd() const { return fd_; }
+
+        private:
+            // Makes at least n bytes available in the buffer, false at the end of the input.
+            // The buffer grows as bytes arrive, so a forged length cannot allocate more than the input holds,
+            // and returns to its configured size once a larger borrow has been consumed.
+            bool fill(const size_t n) {
+                const size_t kept = end_ - pos_;
+                if (capacity_ > base_capacity_ && n <= base_capacity_ && kept <= base_capacity_) {
+                    auto smaller = std::make_unique_for_overwrite<uint8_t[]>(base_capacity_);
+                    std::memcpy(smaller.get(), buf_.get() + pos_, kept);
+                    buf_ = std::move(smaller);
+                    capacity_ = base_capacity_;
+                } else {
+                    std::memmove(buf_.get(), buf_.get() + pos_, kept);
+                }
+                end_ = kept;
+                pos_ = 0;
+
+                while (end_ < n) {
+                    if (end_ == capacity_) {
+                        const size_t grown = std::min(n, capacity_ * 2);
+                        auto bigger = std::make_unique_for_overwrite<uint8_t[]>(grown);
+                        std::memcpy(bigger.get(), buf_.get(), end_);
+                        buf_ = std::move(bigger);
+                        capacity_ = grown;
+                    }
+                    iovec iov{buf_.get() + end_, capacity_ - end_};
+                    const size_t got = readv_some(&iov, 1);
+                    if (got == 0) return false;
+                    end_ += got;
+                }
+                return true;
+            }
+
+            size_t readv_some(iovec *iov, const int count) const {
+                while (true) {
+                    const ssize_t k = ::readv(fd_, iov, count);
+                    if (k >= 0) return static_cast<size_t>(k);
+                    if (errno != EINTR)
+                        BSP_THROW(errors::error(errors::code::runtime_error,
+                                                detail::concat("error when reading fd ", fd_, ": ",
+                                                               std::string(std::strerror(errno)))));
+                }
+            }
+
+            int fd_;
+            size_t base_capacity_;
+            size_t capacity_;
+            std::unique_ptr<uint8_t[]> buf_;
+            size_t pos_ = 0;
+            size_t end_ = 0;
+        };
+    }
+#endif
+
+
     // === Wrappers ============================================================
     // 包装类
     namespace types {
@@ -1091,6 +3046,97 @@ namespace bsp {
         };
 
         using bytes = std::vector<uint8_t>;
+
+        class slice {
+        public:
+            slice() = default;
+
+            // owner keeps [data, data + size) alive
+            slice(std::shared_ptr<const void> owner, const uint8_t *data, const size_t size)
+                : owner_(std::move(owner)), data_(data), size_(size) {
+            }
+
+            // Takes over a buffer without copying it
+            [[nodiscard]] static slice adopt(bytes &&buf) {
+                auto owner = std::make_shared<const bytes>(std::move(buf));
+                return {owner, owner->data(), owner->size()};
+            }
+
+            [[nodiscard]] static slice copy(const uint8_t *p, const size_t n) {
+                return adopt(bytes(p, p + n));
+            }
+
+            [[nodiscard]] const uint8_t *data() const { return data_; }
+            [[nodiscard]] size_t size() const { return size_; }
+            [[nodiscard]] bool empty() const { return size_ == 0; }
+            [[nodiscard]] const uint8_t *begin() const { return data_; }
+            [[nodiscard]] const uint8_t *end() const { return data_ + size_; }
+            [[nodiscard]] uint8_t operator[](const size_t i) const { return data_[i]; }
+
+            [[nodiscard]] std::span<const uint8_t> span() const { return {data_, size_}; }
+            [[nodiscard]] bytes to_bytes() const { return {begin(), end()}; }
+            [[nodiscard]] const std::shared_ptr<const void> &owner() const { return owner_; }
+
+            // n bytes from offset, sharing the same buffer
+            [[nodiscard]] slice sub(const size_t offset, const size_t n) const {
+                if (offset > size_ || n > size_ - offset)
+                    BSP_THROW(errors::unexpected_eof(n, offset > size_ ? 0 : size_ - offset, "types::slice"));
+                return {owner_, data_ + offset, n};
+            }
+
+            friend bool operator==(const slice &a, const slice &b) {
+                return a.size_ == b.size_ && (a.size_ == 0 || memcmp(a.data_, b.data_, a.size_) == 0);
+            }
+
+        private:
+            std::shared_ptr<const void> owner_;
+            const uint8_t *data_ = nullptr;
+            size_t size_ = 0;
+        };
+    }
+
+    // === Slice I/O ===========================================================
+    // 切片 I/O
+    namespace io {
+        struct SliceReader {
+            types::slice source;
+            size_t pos = 0;
+
+            explicit SliceReader(types::slice source_) : source(std::move(source_)) {
+            }
+
+            void read_bytes(uint8_t *buf, const std::streamsize n) {
+                memcpy(buf, borrow_bytes(static_cast<size_t>(n)), static_cast<size_t>(n));
+            }
+
+            [[nodiscard]] uint8_t read_byte() {
+                if (pos >= source.size())
+                    BSP_THROW(errors::unexpected_eof(1, 0, "SliceReader"));
+                return source[pos++];
+            }
+
+            [[nodiscard]] const uint8_t *borrow_bytes(const size_t n) {
+                if (n > source.size() - pos)
+                    BSP_THROW(errors::unexpected_eof(n, source.size() - pos, "SliceReader"));
+                const uint8_t *p = source.data() + pos;
+                pos += n;
+                return p;
+            }
+
+            [[nodiscard]] types::slice borrow_slice(const size_t n) {
+                if (n > source.size() - pos)
+                    BSP_THROW(errors::unexpected_eof(n, source.size() - pos, "SliceReader"));
+                types::slice s(source.owner(), source.data() + pos, n);
+                pos += n;
+                return s;
+            }
+
+            void skip(const size_t n) {
+                (void) borrow_bytes(n);
+            }
+
+            [[nodiscard]] size_t remaining() const { return source.size() - pos; }
+        };
     }
 
 
@@ -1125,6 +3171,26 @@ namespace bsp {
         struct DynSchema {
         };
 
+        template<bool Sized = true>
+        struct Versioned {
+        };
+
+        template<size_t Version = SIZE_MAX>
+        struct Tagged {
+        };
+
+        template<typename Inner = Default>
+        struct Indexed {
+        };
+
+        template<size_t Version = SIZE_MAX>
+        struct Columnar {
+        };
+
+        template<typename Inner = Default>
+        struct Chunked {
+        };
+
         struct Trivial {
         };
 
@@ -1151,8 +3217,8 @@ namespace bsp {
         template<typename T, typename Proto>
         struct Serializer {
             // Interface:
-            // static void write(io::Writer auto &w, const T &v, context &ctx);
-            // static void read(io::Reader auto &r, T &out, context &ctx);
+            // static void write(io::Writer auto &w, const T &v, context_like auto &ctx);
+            // static void read(io::Reader auto &r, T &out, context_like auto &ctx);
         };
 
         template<typename T>
@@ -1170,6 +3236,7 @@ namespace bsp {
 
             const char *name;
             field_type Class::*ptr;
+            size_t id; // Field id for Tagged, 0 means position + 1
         };
 
         template<size_t Version, typename... Fields>
@@ -1193,22 +3260,16 @@ namespace bsp {
         // --- Schema Version Match --------------------------------------------
         // 模式查找
         template<typename T>
-        constexpr size_t match_schema_index(const size_t target) {
-            constexpr auto &schemas = SchemaSet<T>::schemas;
-            constexpr size_t count = SchemaSet<T>::schema_count;
-            size_t result = SIZE_MAX;
+        inline constexpr auto schema_versions = []<size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<size_t, sizeof...(Is)>{std::get<Is>(SchemaSet<T>::schemas).version...};
+        }(std::make_index_sequence<SchemaSet<T>::schema_count>{});
 
-            [&]<size_t... Is>(std::index_sequence<Is...>) {
-                (
-                    (
-                        std::get<count - 1 - Is>(schemas).version <= target
-                            ? (result = count - 1 - Is, true)
-                            : false
-                    ) || ...
-                );
-            }(std::make_index_sequence<count>{});
-
-            return result;
+        // Versions ascend (checked by validate_schemas), so the last one <= target is a binary search
+        template<typename T>
+        constexpr size_t match_schema_index(const size_t target) {
+            constexpr auto &versions = schema_versions<T>;
+            const size_t n = std::upper_bound(versions.begin(), versions.end(), target) - versions.begin();
+            return n == 0 ? SIZE_MAX : n - 1;
         }
 
         template<typename T, size_t target>
@@ -1322,8 +3383,8 @@ namespace bsp {
 
         // --- Container Types -------------------------------------------------
         // 容器类型
-        template<>
-        struct DefaultProtocol<std::string> {
+        template<typename A>
+        struct DefaultProtocol<std::basic_string<char, std::char_traits<char>, A> > {
             using type = Varint;
         };
 
@@ -1332,8 +3393,13 @@ namespace bsp {
             using type = Varint;
         };
 
-        template<typename T>
-        struct DefaultProtocol<std::vector<T> > {
+        template<>
+        struct DefaultProtocol<types::slice> {
+            using type = Varint;
+        };
+
+        template<typename T, typename A>
+        struct DefaultProtocol<std::vector<T, A> > {
             using type = Varint;
         };
 
@@ -1342,23 +3408,23 @@ namespace bsp {
             using type = Fixed<>;
         };
 
-        template<typename K, typename V>
-        struct DefaultProtocol<std::map<K, V> > {
+        template<typename K, typename V, typename A>
+        struct DefaultProtocol<std::map<K, V, std::less<K>, A> > {
             using type = Varint;
         };
 
-        template<typename K, typename V>
-        struct DefaultProtocol<std::unordered_map<K, V> > {
+        template<typename K, typename V, typename A>
+        struct DefaultProtocol<std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, A> > {
             using type = Varint;
         };
 
-        template<typename T>
-        struct DefaultProtocol<std::set<T> > {
+        template<typename T, typename A>
+        struct DefaultProtocol<std::set<T, std::less<T>, A> > {
             using type = Varint;
         };
 
-        template<typename T>
-        struct DefaultProtocol<std::unordered_set<T> > {
+        template<typename T, typename A>
+        struct DefaultProtocol<std::unordered_set<T, std::hash<T>, std::equal_to<T>, A> > {
             using type = Varint;
         };
 
@@ -1388,6 +3454,11 @@ namespace bsp {
             using type = Schema<INT_MAX>;
         };
 
+        template<typename T, size_t V>
+        struct DefaultProtocol<columns<T, V> > {
+            using type = Columnar<V>;
+        };
+
 
         // --- Variable Types --------------------------------------------------
         // 可变类型
@@ -1480,6 +3551,14 @@ namespace bsp {
             w.write_byte(v);
         }
 
+        // Payload bytes owned by the value being written, borrowed when the writer supports it
+        void write_payload(io::Writer auto &w, const void *p, const size_t n) {
+            if constexpr (io::BorrowingWriter<std::remove_reference_t<decltype(w)> >)
+                w.write_borrowed(static_cast<const uint8_t *>(p), n);
+            else
+                w.write_bytes(static_cast<const uint8_t *>(p), static_cast<std::streamsize>(n));
+        }
+
         template<std::unsigned_integral T>
         [[nodiscard]] T read_varint(io::Reader auto &r, const bool overflow_error) {
             T result = 0;
@@ -1487,11 +3566,16 @@ namespace bsp {
 
             while (true) {
                 if (overflow_error)
-                    if (shift >= static_cast<int>(sizeof(T) * 8))
-                        throw errors::make(errors::code::varint_overflow,
-                                           detail::concat("varint overflow (max bits=",
-                                                          static_cast<uint8_t>(std::ceil(sizeof(T) * 8.0 / 7)),
-                                                          ")"));
+                    if (shift >= static_cast<int>(sizeof(T) * 8)) {
+                        if constexpr (io::FallibleReader<std::remove_reference_t<decltype(r)> >) {
+                            r.fail(errors::code::varint_overflow);
+                            return result;
+                        }
+                        BSP_THROW(errors::make(errors::code::varint_overflow,
+                                               detail::concat("varint overflow (max bits=",
+                                                              static_cast<uint8_t>(std::ceil(sizeof(T) * 8.0 / 7)),
+                                                              ")")));
+                    }
 
                 const uint8_t b = r.read_byte();
                 result |= T(b & 0x7F) << shift;
@@ -1623,1342 +3707,3951 @@ namespace bsp {
             }
         }
 
-        // --- Schema Fields Access --------------------------------------------
-        // 字段读写
+        // --- Memory Layout Detection -----------------------------------------
+        // 内存布局检测
 
-        template<typename T, typename Entry>
-        void write_fields(io::Writer auto &w, const T &v, context &ctx, const Entry &entry,
-                          const std::string &type_name, const std::string &proto_name) {
-            [[maybe_unused]] const char *current_field = nullptr;
+        // memcpy_layout<T, P> is true when Serializer<T, P> writes exactly the object representation of T
+        // and accepts any byte pattern when reading. Such values (and arrays of them) can be copied at once.
+        template<typename T, typename Proto>
+        struct memcpy_layout : std::false_type {
+        };
 
-            auto g = ctx.guard<true, false, false>([&] {
-                return errors::value_frame{
-                    .type = type_name,
-                    .proto = proto_name,
-                    .child_label = current_field
-                                       ? std::optional(concat("Field \"", current_field, "\""))
-                                       : std::nullopt,
-                    .details = detail::concat("exact version ", entry.version)
-                };
-            });
+        template<typename T> requires (!std::is_same_v<proto::DefaultProtocol_t<T>, proto::Default>)
+        struct memcpy_layout<T, proto::Default> : memcpy_layout<T, proto::DefaultProtocol_t<T> > {
+        };
 
-            std::apply([&](const auto &... field) {
-                (
-                    (
-                        current_field = field.name,
-                        serialize::Serializer<
-                            typename std::decay_t<decltype(field)>::field_type,
-                            typename std::decay_t<decltype(field)>::protocol
-                        >::write(w, v.*(field.ptr), ctx)
-                    ),
-                    ...
-                );
-            }, entry.fields);
-        }
+        // bool is excluded: reading validates the byte under STRICT policy
+        template<std::integral T> requires (!std::is_same_v<T, bool>)
+        struct memcpy_layout<T, proto::Fixed<> > : std::bool_constant<sizeof(T) == 1 || endian == std::endian::native> {
+        };
 
-        template<typename T, typename Entry>
-        void read_fields(io::Reader auto &r, T &out, context &ctx, const Entry &entry,
-                         const std::string &type_name, const std::string &proto_name) {
-            [[maybe_unused]] const char *current_field = nullptr;
+        template<std::floating_point T> requires (std::numeric_limits<T>::is_iec559 && (sizeof(T) == 4 || sizeof(T) == 8))
+        struct memcpy_layout<T, proto::Fixed<> > : std::bool_constant<endian == std::endian::native> {
+        };
 
-            auto g = ctx.guard<true, false, false>([&] {
-                return errors::value_frame{
-                    .type = type_name,
-                    .proto = proto_name,
-                    .child_label = current_field
-                                       ? std::optional(concat("Field \"", current_field, "\""))
-                                       : std::nullopt,
-                    .details = detail::concat("exact version ", entry.version)
-                };
-            });
+        template<typename T> requires types::trivial_serializable<T>
+        struct memcpy_layout<T, proto::Trivial> : std::true_type {
+        };
 
-            std::apply([&](const auto &... field) {
-                (
-                    (
-                        current_field = field.name,
-                        serialize::Serializer<
-                            typename std::decay_t<decltype(field)>::field_type,
-                            typename std::decay_t<decltype(field)>::protocol
-                        >::read(r, out.*(field.ptr), ctx)
-                    ),
-                    ...
-                );
-            }, entry.fields);
-        }
-    }
+        template<typename T, size_t N>
+        struct memcpy_layout<std::array<T, N>, proto::Fixed<> > : memcpy_layout<T, proto::Default> {
+        };
 
-    // === Serializers =========================================================
-    // 序列化器特化实现
-    namespace serialize {
-        // ~~~ Serializers for Types ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-        // 为特定类型设计的序列化器
+        // Types whose constexpr value-initialization is possible
+        template<typename T>
+        concept constexpr_default_constructible = requires
+        {
+            typename std::integral_constant<bool, (T{}, true)>;
+        };
 
-        // --- Serializers for Value Types  ------------------------------------
-        // 数据类型的序列化器
-        // bool
-        // [0/1 Bool]
-        template<>
-        struct Serializer<bool, proto::Fixed<> > {
-            static void write(io::Writer auto &w, const bool &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("bool", "Fixed<>"); });
-                w.write_byte(v);
-            }
-
-            static void read(io::Reader auto &r, bool &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("bool", "Fixed<>"); });
-                if (ctx.sf.policy <= errors::error_policy::STRICT) {
-                    const uint8_t b = r.read_byte();
-                    if (b > 1)
-                        throw errors::invalid_bool(b, ctx);
-                    out = b;
-                } else {
-                    out = r.read_byte();
-                }
+        // A schema entry is memcpy-able when its fields cover the whole struct in declaration order,
+        // without padding, and every field is memcpy-able itself.
+        template<typename T, size_t Index>
+        consteval bool is_memcpy_entry() {
+            if constexpr (!(std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T> &&
+                            constexpr_default_constructible<T>)) {
+                return false;
+            } else {
+                constexpr auto &entry = std::get<Index>(schema::SchemaSet<T>::schemas);
+
+                return std::apply([](const auto &... field) {
+                    if constexpr (!(memcpy_layout<
+                        typename std::decay_t<decltype(field)>::field_type,
+                        typename std::decay_t<decltype(field)>::protocol
+                    >::value && ...)) {
+                        return false;
+                    } else {
+                        constexpr size_t total = (size_t{0} + ... + sizeof(
+                                                      typename std::decay_t<decltype(field)>::field_type));
+                        if (total != sizeof(T)) return false;
+
+                        // Members compare by declaration order, so ascending addresses + full coverage = no padding
+                        T probe{};
+                        const void *addresses[] = {static_cast<const void *>(&(probe.*(field.ptr)))...};
+                        for (size_t i = 1; i < sizeof...(field); ++i)
+                            if (!(addresses[i - 1] < addresses[i])) return false;
+                        return true;
+                    }
+                }, entry.fields);
             }
+        }
+
+        template<typename T, size_t V>
+        consteval bool is_memcpy_schema() {
+            constexpr size_t index = schema::match_schema_index<T, V>();
+            if constexpr (index == SIZE_MAX) return false;
+            else return is_memcpy_entry<T, index>();
+        }
+
+        template<typename T, size_t V> requires types::schema_serializable<T>
+        struct memcpy_layout<T, proto::Schema<V> > : std::bool_constant<is_memcpy_schema<T, V>()> {
         };
 
-        // Integral
-        template<std::integral T>
-        struct Serializer<T, proto::Fixed<> > {
-            static constexpr const char *t_str = detail::type_name_of<T>();
+        // --- Fixed-Width Encoding --------------------------------------------
+        // 定长编码
 
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Fixed<>"); });
-                const auto x = detail::adapt_endian(v);
-                w.write_bytes(reinterpret_cast<const uint8_t *>(&x), sizeof(T));
-            }
+        // fixed_wire<T, P> describes a T-P pair that always encodes to `size` bytes.
+        // store/load work on raw memory, so a run of such values needs only one bounds check.
+        template<typename T, typename Proto>
+        struct fixed_wire {
+        };
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Fixed<>"); });
-                T x;
-                r.read_bytes(reinterpret_cast<uint8_t *>(&x), sizeof(T));
-                out = detail::adapt_endian(x);
-            }
+        template<typename T, typename Proto>
+        concept fixed_width = requires
+        {
+            { fixed_wire<T, Proto>::size } -> std::convertible_to<size_t>;
         };
 
-        // [LEB128 Varint]
-        // Not affected by endian
-        template<std::unsigned_integral T>
-        struct Serializer<T, proto::Varint> {
-            static constexpr const char *t_str = detail::type_name_of<T>();
+        template<typename T> requires (!std::is_same_v<proto::DefaultProtocol_t<T>, proto::Default>)
+        struct fixed_wire<T, proto::Default> : fixed_wire<T, proto::DefaultProtocol_t<T> > {
+        };
+
+        template<>
+        struct fixed_wire<bool, proto::Fixed<> > {
+            static constexpr size_t size = 1;
 
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Varint"); });
-                detail::write_varint(w, v);
+            static void store(uint8_t *p, const bool &v) {
+                *p = v;
             }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Varint"); });
-                out = detail::read_varint<T>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
+            static void load(const uint8_t *p, bool &out, context_like auto &ctx) {
+                if (detail::checks(ctx, errors::error_policy::STRICT) && *p > 1) {
+                    return fail(ctx, errors::code::invalid_bool, [&] {
+                        // Loads inside a run have no guard of their own
+                        auto e = errors::invalid_bool(*p, ctx);
+                        if constexpr (detail::traced<decltype(ctx)>)
+                            ctx.get_traceback().push(errors::value_frame("bool", "Fixed<>"));
+                        return e;
+                    });
+                }
+                out = *p;
             }
         };
 
-        // [ZigZag+LEB128 Varint]
-        // Not affected by endian
-        template<std::signed_integral T>
-        struct Serializer<T, proto::Varint> {
-            static constexpr const char *t_str = detail::type_name_of<T>();
+        template<std::integral T> requires (!std::is_same_v<T, bool>)
+        struct fixed_wire<T, proto::Fixed<> > {
+            static constexpr size_t size = sizeof(T);
 
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Varint"); });
-                detail::write_varint(w, detail::zigzag_encode(v));
+            static void store(uint8_t *p, const T &v) {
+                const T x = adapt_endian(v);
+                std::memcpy(p, &x, sizeof(T));
             }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Varint"); });
-                out = detail::zigzag_decode(
-                    detail::read_varint<std::make_unsigned_t<T> >(r, ctx.sf.policy <= errors::error_policy::MEDIUM));
+            static void load(const uint8_t *p, T &out, context_like auto &) {
+                T x;
+                std::memcpy(&x, p, sizeof(T));
+                out = adapt_endian(x);
             }
         };
 
-        // Floating
-        template<std::floating_point T> requires std::numeric_limits<T>::is_iec559
-        struct Serializer<T, proto::Fixed<> > {
+        template<std::floating_point T> requires (std::numeric_limits<T>::is_iec559 && (sizeof(T) == 4 || sizeof(T) == 8))
+        struct fixed_wire<T, proto::Fixed<> > {
             using U = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
-            static constexpr const char *t_str = detail::type_name_of<T>();
+            static constexpr size_t size = sizeof(T);
 
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Fixed<>"); });
-                const U x = detail::adapt_endian(std::bit_cast<U>(v));
-                w.write_bytes(reinterpret_cast<const uint8_t *>(&x), sizeof(T));
+            static void store(uint8_t *p, const T &v) {
+                const U x = adapt_endian(std::bit_cast<U>(v));
+                std::memcpy(p, &x, sizeof(U));
             }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Fixed<>"); });
+            static void load(const uint8_t *p, T &out, context_like auto &) {
                 U x;
-                r.read_bytes(reinterpret_cast<uint8_t *>(&x), sizeof(T));
-                out = std::bit_cast<T>(detail::adapt_endian(x));
+                std::memcpy(&x, p, sizeof(U));
+                out = std::bit_cast<T>(adapt_endian(x));
             }
         };
 
+        template<typename T> requires types::trivial_serializable<T>
+        struct fixed_wire<T, proto::Trivial> {
+            static constexpr size_t size = sizeof(T);
 
-        // --- Serializers for Container Types ---------------------------------
-        // 容器类型的序列化器
-        // std::string
-        // [Varint length][String]
-        template<>
-        struct Serializer<std::string, proto::Varint> {
-            static void write(io::Writer auto &w, const std::string &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::value_frame{
-                        "std::string", "Varint", std::nullopt,
-                        detail::concat("length=", v.size())
-                    };
-                });
-                detail::write_varint(w, v.size());
-                w.write_bytes(reinterpret_cast<const uint8_t *>(v.data()), v.size());
+            static void store(uint8_t *p, const T &v) {
+                std::memcpy(p, &v, sizeof(T));
             }
 
-            static void read(io::Reader auto &r, std::string &out, context &ctx) {
-                size_t size = 0;
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::value_frame{
-                        "std::string", "Varint", std::nullopt,
-                        detail::concat("length=", size)
-                    };
-                });
-                size = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-
-                if (ctx.sf.policy <= errors::error_policy::MEDIUM)
-                    if (size > ctx.sf.max_string_size)
-                        throw errors::string_too_large(size, ctx);
-
-                out.resize(size);
-                r.read_bytes(reinterpret_cast<uint8_t *>(out.data()), size);
+            static void load(const uint8_t *p, T &out, context_like auto &) {
+                std::memcpy(&out, p, sizeof(T));
             }
         };
 
-        // [String]
-        template<size_t N>
-        struct Serializer<std::string, proto::Fixed<N> > {
-            static std::string p_str() { return detail::concat("Fixed<", N, ">"); }
-
-            static void write(io::Writer auto &w, const std::string &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("std::string", p_str()); });
-                if (v.size() != N) throw errors::fixed_size_mismatch(N, v.size(), ctx);
+        template<typename T, size_t N> requires fixed_width<T, proto::Default>
+        struct fixed_wire<std::array<T, N>, proto::Fixed<> > {
+            using E = fixed_wire<T, proto::Default>;
+            static constexpr size_t size = N * E::size;
 
-                w.write_bytes(reinterpret_cast<const uint8_t *>(v.data()), v.size());
+            static void store(uint8_t *p, const std::array<T, N> &v) {
+                for (size_t i = 0; i < N; ++i)
+                    E::store(p + i * E::size, v[i]);
             }
 
-            static void read(io::Reader auto &r, std::string &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("std::string", p_str()); });
-
-                out.resize(N);
-                r.read_bytes(reinterpret_cast<uint8_t *>(out.data()), N);
+            static void load(const uint8_t *p, std::array<T, N> &out, context_like auto &ctx) {
+                for (size_t i = 0; i < N; ++i)
+                    E::load(p + i * E::size, out[i], ctx);
             }
         };
 
-        // types::bytes (std::vector<uint8_t>)
-        // [Varint length][Bytearray]
-        template<>
-        struct Serializer<types::bytes, proto::Varint> {
-            static void write(io::Writer auto &w, const types::bytes &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::value_frame{
-                        "types::bytes", "Varint", std::nullopt,
-                        detail::concat("length=", v.size())
-                    };
-                });
-                detail::write_varint(w, v.size());
-                w.write_bytes(v.data(), v.size());
-            }
-
-            static void read(io::Reader auto &r, types::bytes &out, context &ctx) {
-                size_t size = 0;
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::value_frame{
-                        "types::bytes", "Varint", std::nullopt,
-                        detail::concat("length=", size)
-                    };
-                });
-                size = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
+        template<typename T, size_t Index>
+        using entry_fields_t = std::remove_cvref_t<decltype(std::get<Index>(schema::SchemaSet<T>::schemas).fields)>;
 
-                if (ctx.sf.policy <= errors::error_policy::MEDIUM)
-                    if (size > ctx.sf.max_string_size)
-                        throw errors::string_too_large(size, ctx);
+        template<typename Fields>
+        struct fixed_fields;
 
-                out.resize(size);
-                r.read_bytes(out.data(), size);
-            }
+        template<typename... Fields>
+        struct fixed_fields<std::tuple<Fields...> > : std::bool_constant<
+                    (fixed_width<typename Fields::field_type, typename Fields::protocol> && ...)> {
         };
 
-        // [Bytearray]
-        template<size_t N>
-        struct Serializer<types::bytes, proto::Fixed<N> > {
-            static std::string p_str() { return detail::concat("Fixed<", N, ">"); }
+        template<typename T, size_t V>
+        consteval bool is_fixed_schema() {
+            constexpr size_t index = schema::match_schema_index<T, V>();
+            if constexpr (index == SIZE_MAX) return false;
+            else return fixed_fields<entry_fields_t<T, index> >::value;
+        }
 
-            static void write(io::Writer auto &w, const types::bytes &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("types::bytes", p_str()); });
-                if (v.size() != N) throw errors::fixed_size_mismatch(N, v.size(), ctx);
-                w.write_bytes(v.data(), v.size());
+        // Schemas whose fields are all fixed-width are fixed-width themselves
+        template<typename T, size_t V> requires (types::schema_serializable<T> && is_fixed_schema<T, V>())
+        struct fixed_wire<T, proto::Schema<V> > {
+            static constexpr size_t index = schema::match_schema_index<T, V>();
+            static constexpr const auto &fields = std::get<index>(schema::SchemaSet<T>::schemas).fields;
+            static constexpr size_t size = []<size_t... Is>(std::index_sequence<Is...>) {
+                return (size_t{0} + ... + fixed_wire<
+                            typename std::tuple_element_t<Is, entry_fields_t<T, index> >::field_type,
+                            typename std::tuple_element_t<Is, entry_fields_t<T, index> >::protocol>::size);
+            }(std::make_index_sequence<std::tuple_size_v<entry_fields_t<T, index> > >{});
+
+            static void store(uint8_t *p, const T &v) {
+                std::apply([&](const auto &... field) {
+                    ((fixed_wire<
+                            typename std::decay_t<decltype(field)>::field_type,
+                            typename std::decay_t<decltype(field)>::protocol
+                        >::store(p, v.*(field.ptr)),
+                        p += fixed_wire<
+                            typename std::decay_t<decltype(field)>::field_type,
+                            typename std::decay_t<decltype(field)>::protocol
+                        >::size), ...);
+                }, fields);
             }
 
-            static void read(io::Reader auto &r, types::bytes &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("types::bytes", p_str()); });
-                out.resize(N);
-                r.read_bytes(out.data(), N);
+            static void load(const uint8_t *p, T &out, context_like auto &ctx) {
+                std::apply([&](const auto &... field) {
+                    ((fixed_wire<
+                            typename std::decay_t<decltype(field)>::field_type,
+                            typename std::decay_t<decltype(field)>::protocol
+                        >::load(p, out.*(field.ptr), ctx),
+                        p += fixed_wire<
+                            typename std::decay_t<decltype(field)>::field_type,
+                            typename std::decay_t<decltype(field)>::protocol
+                        >::size), ...);
+                }, fields);
             }
         };
 
-        // std::vector
-        // [Varint length][Value 0][Value 1]...
-        template<typename T> requires types::default_serializable<T>
-        struct Serializer<std::vector<T>, proto::Varint> {
-            static void write(io::Writer auto &w, const std::vector<T> &v, context &ctx) {
-                size_t index = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::vector", "Varint", detail::concat("Elem ", index),
-                        detail::concat("length=", v.size())
-                    };
-                });
-                detail::write_varint(w, v.size());
-
-                for (; index < v.size(); ++index) {
-                    DefaultSerializer<T>::write(w, v[index], ctx);
+        // Largest run (in bytes) that is staged on the stack for non-contiguous readers/writers
+        static constexpr inline size_t max_stack_run = 512;
+
+        // Sequences of fixed-width values: a single bounds check for contiguous I/O, stack-staged blocks otherwise.
+        // at(i) returns the i-th value, so strided values (e.g. one field of many structs) work as well.
+        template<typename T, typename Proto, typename At> requires fixed_width<T, Proto>
+        void write_fixed_each(io::Writer auto &w, const size_t n, At &&at) {
+            using E = fixed_wire<T, Proto>;
+
+            if constexpr (io::ContiguousWriter<std::remove_cvref_t<decltype(w)> >) {
+                uint8_t *p = w.reserve_bytes(n * E::size);
+                for (size_t i = 0; i < n; ++i)
+                    E::store(p + i * E::size, at(i));
+            } else if constexpr (E::size > max_stack_run) {
+                // Wider than a stack run, elements go one at a time through a heap buffer
+                const auto buf = std::make_unique_for_overwrite<uint8_t[]>(E::size);
+                for (size_t i = 0; i < n; ++i) {
+                    E::store(buf.get(), at(i));
+                    w.write_bytes(buf.get(), static_cast<std::streamsize>(E::size));
+                }
+            } else {
+                constexpr size_t block = max_stack_run / E::size;
+                uint8_t buf[block * E::size];
+                for (size_t i = 0; i < n; i += block) {
+                    const size_t k = std::min(block, n - i);
+                    for (size_t j = 0; j < k; ++j)
+                        E::store(buf + j * E::size, at(i + j));
+                    w.write_bytes(buf, static_cast<std::streamsize>(k * E::size));
                 }
             }
+        }
 
-            static void read(io::Reader auto &r, std::vector<T> &out, context &ctx) {
-                size_t index = 0;
-                size_t size = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::vector", "Varint", detail::concat("Elem ", index),
-                        detail::concat("length=", size)
-                    };
-                });
-
-                size = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-                if (ctx.sf.policy <= errors::error_policy::MEDIUM)
-                    if (size > ctx.sf.max_container_size) throw errors::container_too_large(size, ctx);
-
-                out.resize(size);
-                for (; index < size; ++index) {
-                    DefaultSerializer<T>::read(r, out[index], ctx);
+        template<typename T, typename Proto, typename At> requires fixed_width<T, Proto>
+        void read_fixed_each(io::Reader auto &r, const size_t n, context_like auto &ctx, At &&at) {
+            using E = fixed_wire<T, Proto>;
+
+            if constexpr (io::ContiguousReader<std::remove_cvref_t<decltype(r)> >) {
+                const uint8_t *p = r.borrow_bytes(n * E::size);
+                for (size_t i = 0; i < n; ++i)
+                    E::load(p + i * E::size, at(i), ctx);
+            } else if constexpr (E::size > max_stack_run) {
+                const auto buf = std::make_unique_for_overwrite<uint8_t[]>(E::size);
+                for (size_t i = 0; i < n; ++i) {
+                    r.read_bytes(buf.get(), static_cast<std::streamsize>(E::size));
+                    E::load(buf.get(), at(i), ctx);
+                }
+            } else {
+                constexpr size_t block = max_stack_run / E::size;
+                uint8_t buf[block * E::size];
+                for (size_t i = 0; i < n; i += block) {
+                    const size_t k = std::min(block, n - i);
+                    r.read_bytes(buf, static_cast<std::streamsize>(k * E::size));
+                    for (size_t j = 0; j < k; ++j)
+                        E::load(buf + j * E::size, at(i + j), ctx);
                 }
             }
-        };
+        }
 
-        // [Value 0][Value 1]...
-        template<typename T, size_t N> requires types::default_serializable<T>
-        struct Serializer<std::vector<T>, proto::Fixed<N> > {
-            static std::string p_str() { return detail::concat("Fixed<", N, ">"); }
+        template<typename T, typename Proto> requires fixed_width<T, Proto>
+        void write_fixed_array(io::Writer auto &w, const T *data, const size_t n) {
+            if constexpr (memcpy_layout<T, Proto>::value)
+                w.write_bytes(reinterpret_cast<const uint8_t *>(data), n * sizeof(T));
+            else
+                write_fixed_each<T, Proto>(w, n, [data](const size_t i) -> const T & { return data[i]; });
+        }
 
-            static void write(io::Writer auto &w, const std::vector<T> &v, context &ctx) {
-                size_t index = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::vector", p_str(), detail::concat("Elem ", index)
-                    };
-                });
-                if (v.size() != N) throw errors::fixed_size_mismatch(N, v.size(), ctx);
+        template<typename T, typename Proto> requires fixed_width<T, Proto>
+        void read_fixed_array(io::Reader auto &r, T *out, const size_t n, context_like auto &ctx) {
+            if constexpr (memcpy_layout<T, Proto>::value)
+                r.read_bytes(reinterpret_cast<uint8_t *>(out), n * sizeof(T));
+            else
+                read_fixed_each<T, Proto>(r, n, ctx, [out](const size_t i) -> T & { return out[i]; });
+        }
 
-                for (; index < N; ++index) {
-                    DefaultSerializer<T>::write(w, v[index], ctx);
-                }
+        // --- Fixed-Width Field Runs ------------------------------------------
+        // 定长字段段
+
+        // End (exclusive) of the maximal run of fixed-width fields starting at field I
+        template<typename T, size_t Index, size_t I>
+        consteval size_t fixed_run_end() {
+            using Fields = entry_fields_t<T, Index>;
+            if constexpr (I >= std::tuple_size_v<Fields>) {
+                return I;
+            } else if constexpr (fixed_width<typename std::tuple_element_t<I, Fields>::field_type,
+                typename std::tuple_element_t<I, Fields>::protocol>) {
+                return fixed_run_end<T, Index, I + 1>();
+            } else {
+                return I;
             }
+        }
 
-            static void read(io::Reader auto &r, std::vector<T> &out, context &ctx) {
-                size_t index = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::vector", p_str(), detail::concat("Elem ", index)
-                    };
-                });
-
-                out.resize(N);
-                for (; index < N; ++index) {
-                    DefaultSerializer<T>::read(r, out[index], ctx);
-                }
-            }
-        };
+        template<typename T, size_t Index, size_t Begin, size_t End>
+        consteval size_t fixed_run_size() {
+            using Fields = entry_fields_t<T, Index>;
+            return []<size_t... Is>(std::index_sequence<Is...>) {
+                return (size_t{0} + ... + fixed_wire<
+                            typename std::tuple_element_t<Begin + Is, Fields>::field_type,
+                            typename std::tuple_element_t<Begin + Is, Fields>::protocol>::size);
+            }(std::make_index_sequence<End - Begin>{});
+        }
 
-        // Note: std::vector<bool> is not bit-compressed
-        // Use std::bitset or vector<bool> + Trivial if you want to enable bit-compression
+        template<typename T, size_t Index, size_t Begin, size_t End>
+        void store_run(uint8_t *p, const T &v) {
+            static constexpr const auto &fields = std::get<Index>(schema::SchemaSet<T>::schemas).fields;
+            using Fields = entry_fields_t<T, Index>;
 
-        // std::bitset
-        // Bit-compressed with Little-endian style
-        template<size_t N>
-        struct Serializer<std::bitset<N>, proto::Fixed<> > {
-            static constexpr size_t byte_count = (N + 7) / 8;
+            [&]<size_t... Is>(std::index_sequence<Is...>) {
+                ((fixed_wire<
+                        typename std::tuple_element_t<Begin + Is, Fields>::field_type,
+                        typename std::tuple_element_t<Begin + Is, Fields>::protocol
+                    >::store(p, v.*(std::get<Begin + Is>(fields).ptr)),
+                    p += fixed_wire<
+                        typename std::tuple_element_t<Begin + Is, Fields>::field_type,
+                        typename std::tuple_element_t<Begin + Is, Fields>::protocol
+                    >::size), ...);
+            }(std::make_index_sequence<End - Begin>{});
+        }
 
-            static std::string t_str() {
-                return detail::concat("std::bitset<", N, ">");
-            }
+        template<typename T, size_t Index, size_t Begin, size_t End>
+        void load_run(const uint8_t *p, T &out, context_like auto &ctx, const char *&current_field) {
+            static constexpr const auto &fields = std::get<Index>(schema::SchemaSet<T>::schemas).fields;
+            using Fields = entry_fields_t<T, Index>;
 
-            static void write(io::Writer auto &w, const std::bitset<N> &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str(), "Fixed<>"); });
+            [&]<size_t... Is>(std::index_sequence<Is...>) {
+                ((current_field = std::get<Begin + Is>(fields).name,
+                    fixed_wire<
+                        typename std::tuple_element_t<Begin + Is, Fields>::field_type,
+                        typename std::tuple_element_t<Begin + Is, Fields>::protocol
+                    >::load(p, out.*(std::get<Begin + Is>(fields).ptr), ctx),
+                    p += fixed_wire<
+                        typename std::tuple_element_t<Begin + Is, Fields>::field_type,
+                        typename std::tuple_element_t<Begin + Is, Fields>::protocol
+                    >::size), ...);
+            }(std::make_index_sequence<End - Begin>{});
+        }
 
-                // Serialize as little-endian bytes
-                for (size_t i = 0; i < byte_count; ++i) {
-                    uint8_t byte = 0;
-                    for (size_t bit = 0; bit < 8 && (i * 8 + bit) < N; ++bit) {
-                        if (v[i * 8 + bit])
-                            byte |= (1u << bit);
+        // Writes fields [I, N): runs of fixed-width fields are stored with one capacity check each,
+        // the other fields go through their own serializers.
+        template<typename T, size_t Index, size_t I>
+        void write_fields_from(io::Writer auto &w, const T &v, context_like auto &ctx, const char *&current_field) {
+            static constexpr const auto &fields = std::get<Index>(schema::SchemaSet<T>::schemas).fields;
+            using Fields = entry_fields_t<T, Index>;
+
+            if constexpr (I < std::tuple_size_v<Fields>) {
+                constexpr size_t end = fixed_run_end<T, Index, I>();
+                constexpr size_t size = fixed_run_size<T, Index, I, end>();
+                using W = std::remove_cvref_t<decltype(w)>;
+
+                if constexpr (end != I && (io::ContiguousWriter<W> || size <= max_stack_run)) {
+                    current_field = std::get<I>(fields).name;
+                    if constexpr (io::ContiguousWriter<W>) {
+                        store_run<T, Index, I, end>(w.reserve_bytes(size), v);
+                    } else {
+                        uint8_t buf[size];
+                        store_run<T, Index, I, end>(buf, v);
+                        w.write_bytes(buf, size);
                     }
-                    w.write_byte(byte);
+                    write_fields_from<T, Index, end>(w, v, ctx, current_field);
+                } else {
+                    current_field = std::get<I>(fields).name;
+                    serialize::Serializer<
+                        typename std::tuple_element_t<I, Fields>::field_type,
+                        typename std::tuple_element_t<I, Fields>::protocol
+                    >::write(w, v.*(std::get<I>(fields).ptr), ctx);
+                    write_fields_from<T, Index, I + 1>(w, v, ctx, current_field);
                 }
             }
+        }
 
-            static void read(io::Reader auto &r, std::bitset<N> &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str(), "Fixed<>"); });
+        template<typename T, size_t Index, size_t I>
+        void read_fields_from(io::Reader auto &r, T &out, context_like auto &ctx, const char *&current_field) {
+            static constexpr const auto &fields = std::get<Index>(schema::SchemaSet<T>::schemas).fields;
+            using Fields = entry_fields_t<T, Index>;
 
-                out.reset();
-                for (size_t i = 0; i < byte_count; ++i) {
-                    const uint8_t byte = r.read_byte();
-                    for (size_t bit = 0; bit < 8 && (i * 8 + bit) < N; ++bit) {
-                        if (byte & (1u << bit))
-                            out.set(i * 8 + bit);
+            if constexpr (I < std::tuple_size_v<Fields>) {
+                constexpr size_t end = fixed_run_end<T, Index, I>();
+                constexpr size_t size = fixed_run_size<T, Index, I, end>();
+                using R = std::remove_cvref_t<decltype(r)>;
+
+                if constexpr (end != I && (io::ContiguousReader<R> || size <= max_stack_run)) {
+                    current_field = std::get<I>(fields).name;
+                    if constexpr (io::ContiguousReader<R>) {
+                        load_run<T, Index, I, end>(r.borrow_bytes(size), out, ctx, current_field);
+                    } else {
+                        uint8_t buf[size];
+                        r.read_bytes(buf, size);
+                        load_run<T, Index, I, end>(buf, out, ctx, current_field);
                     }
+                    read_fields_from<T, Index, end>(r, out, ctx, current_field);
+                } else {
+                    current_field = std::get<I>(fields).name;
+                    serialize::Serializer<
+                        typename std::tuple_element_t<I, Fields>::field_type,
+                        typename std::tuple_element_t<I, Fields>::protocol
+                    >::read(r, out.*(std::get<I>(fields).ptr), ctx);
+                    read_fields_from<T, Index, I + 1>(r, out, ctx, current_field);
                 }
             }
-        };
+        }
 
-        // std::map
-        // [Varint length][Key 1][Value 1][Key 2][Value 2]...
-        template<typename K, typename V> requires (types::default_serializable<K> &&
-                                                   types::default_serializable<V>)
-        struct Serializer<std::map<K, V>, proto::Varint> {
-            static void write(io::Writer auto &w, const std::map<K, V> &v, context &ctx) {
-                size_t index = 0;
-                bool is_value = false;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::map", "Varint", detail::concat(is_value ? "Value " : "Key ", index),
-                        detail::concat("length=", v.size())
-                    };
-                });
+        // --- Schema Fields Access --------------------------------------------
+        // 字段读写
 
-                detail::write_varint(w, v.size());
-                for (const auto &[key, value]: v) {
-                    is_value = false;
-                    DefaultSerializer<K>::write(w, key, ctx);
-                    is_value = true;
-                    DefaultSerializer<V>::write(w, value, ctx);
-                    ++index;
+        template<typename T, size_t Index>
+        void write_fields(io::Writer auto &w, const T &v, context_like auto &ctx,
+                          const errors::frame_text &type_name, const errors::frame_text &proto_name) {
+            static constexpr const auto &entry = std::get<Index>(schema::SchemaSet<T>::schemas);
+            [[maybe_unused]] const char *current_field = nullptr;
+
+            auto g = ctx.template guard<true, false, false>([&] {
+                return errors::value_frame{
+                    .type = type_name,
+                    .proto = proto_name,
+                    .child_label = current_field
+                                       ? errors::frame_text{"Field \"", current_field, "\""}
+                                       : errors::frame_text{},
+                    .details = errors::frame_text{"exact version ", entry.version}
+                };
+            });
+
+            if constexpr (is_memcpy_entry<T, Index>()) {
+                w.write_bytes(reinterpret_cast<const uint8_t *>(&v), sizeof(T));
+            } else {
+                write_fields_from<T, Index, 0>(w, v, ctx, current_field);
+            }
+        }
+
+        template<typename T, size_t Index>
+        void read_fields(io::Reader auto &r, T &out, context_like auto &ctx,
+                         const errors::frame_text &type_name, const errors::frame_text &proto_name) {
+            static constexpr const auto &entry = std::get<Index>(schema::SchemaSet<T>::schemas);
+            [[maybe_unused]] const char *current_field = nullptr;
+
+            auto g = ctx.template guard<true, false, false>([&] {
+                return errors::value_frame{
+                    .type = type_name,
+                    .proto = proto_name,
+                    .child_label = current_field
+                                       ? errors::frame_text{"Field \"", current_field, "\""}
+                                       : errors::frame_text{},
+                    .details = errors::frame_text{"exact version ", entry.version}
+                };
+            });
+
+            if constexpr (is_memcpy_entry<T, Index>()) {
+                r.read_bytes(reinterpret_cast<uint8_t *>(&out), sizeof(T));
+            } else {
+                read_fields_from<T, Index, 0>(r, out, ctx, current_field);
+            }
+        }
+
+        // --- Tagged Fields ---------------------------------------------------
+        // 带标签的字段
+
+        // Low 3 bits of a field tag, tell readers how to skip a field they don't know
+        enum class wire_type : uint8_t {
+            varint = 0,
+            fixed8 = 1,
+            fixed16 = 2,
+            fixed32 = 3,
+            fixed64 = 4,
+            length = 5
+        };
+
+        template<typename T, typename Proto>
+        consteval wire_type wire_type_of() {
+            using P = std::conditional_t<std::is_same_v<Proto, proto::Default>, proto::DefaultProtocol_t<T>, Proto>;
+            if constexpr (std::integral<T> && !std::is_same_v<T, bool> && std::is_same_v<P, proto::Varint>) {
+                return wire_type::varint;
+            } else if constexpr (fixed_width<T, Proto>) {
+                constexpr size_t size = fixed_wire<T, Proto>::size;
+                if constexpr (size == 1) return wire_type::fixed8;
+                else if constexpr (size == 2) return wire_type::fixed16;
+                else if constexpr (size == 4) return wire_type::fixed32;
+                else if constexpr (size == 8) return wire_type::fixed64;
+                else return wire_type::length;
+            } else {
+                return wire_type::length;
+            }
+        }
+
+        template<typename T, size_t Index>
+        consteval auto tagged_field_ids() {
+            constexpr const auto &fields = std::get<Index>(schema::SchemaSet<T>::schemas).fields;
+            return [&]<size_t... Is>(std::index_sequence<Is...>) {
+                return std::array<size_t, sizeof...(Is)>{
+                    (std::get<Is>(fields).id != 0 ? std::get<Is>(fields).id : Is + 1)...
+                };
+            }(std::make_index_sequence<std::tuple_size_v<entry_fields_t<T, Index> > >{});
+        }
+
+        template<typename T, size_t Index>
+        consteval bool validate_tagged_ids() {
+            constexpr auto ids = tagged_field_ids<T, Index>();
+            for (size_t i = 0; i < ids.size(); ++i) {
+                if (ids[i] > (SIZE_MAX >> 3)) return false;
+                for (size_t j = i + 1; j < ids.size(); ++j)
+                    if (ids[i] == ids[j]) return false;
+            }
+            return true;
+        }
+
+        // (id, position) pairs sorted by id, looked up by binary search
+        template<typename T, size_t Index>
+        inline constexpr auto tagged_id_table = [] {
+            constexpr auto ids = tagged_field_ids<T, Index>();
+            std::array<std::pair<size_t, size_t>, ids.size()> table{};
+            for (size_t i = 0; i < ids.size(); ++i)
+                table[i] = {ids[i], i};
+            std::sort(table.begin(), table.end());
+            return table;
+        }();
+
+        template<typename T, size_t Index>
+        constexpr size_t tagged_field_pos(const size_t id) {
+            constexpr auto &table = tagged_id_table<T, Index>;
+            const auto it = std::lower_bound(table.begin(), table.end(), std::pair<size_t, size_t>{id, 0});
+            return it != table.end() && it->first == id ? it->second : SIZE_MAX;
+        }
+
+        // Skips n bytes, without copying when the reader is contiguous
+        template<io::Reader R>
+        void skip_bytes(R &r, size_t n) {
+            if constexpr (io::SkippingReader<R>) {
+                r.skip(n);
+            } else if constexpr (io::ContiguousReader<R>) {
+                (void) r.borrow_bytes(n);
+            } else {
+                uint8_t buf[256];
+                while (n) {
+                    const size_t k = std::min(n, sizeof(buf));
+                    r.read_bytes(buf, static_cast<std::streamsize>(k));
+                    n -= k;
+                }
+            }
+        }
+
+        inline void skip_wire(io::Reader auto &r, const wire_type wt, context_like auto &ctx) {
+            switch (wt) {
+                case wire_type::varint:
+                    (void) read_varint<uint64_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                    return;
+                case wire_type::fixed8: return skip_bytes(r, 1);
+                case wire_type::fixed16: return skip_bytes(r, 2);
+                case wire_type::fixed32: return skip_bytes(r, 4);
+                case wire_type::fixed64: return skip_bytes(r, 8);
+                case wire_type::length:
+                    return skip_bytes(r, read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM)));
+            }
+            return detail::fail(ctx, errors::code::invalid_index, [&] {
+                return errors::make(errors::code::invalid_index, ctx,
+                                    concat("unknown wire type ", static_cast<int>(wt)));
+            });
+        }
+
+        // [Varint size][value], write_value(writer) encodes the value.
+        // Sizes come from a pre-pass instead of a temporary buffer. Inside a pre-pass further out,
+        // the value is counted once, so nested sized values are not encoded once per enclosing level.
+        template<typename Fn>
+        void write_sized(io::Writer auto &w, Fn &&write_value) {
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(w)>, io::CountingWriter>) {
+                const size_t start = w.count;
+                write_value(w);
+                write_varint(w, w.count - start);
+            } else {
+                io::CountingWriter counter;
+                write_value(counter);
+                write_varint(w, counter.count);
+                write_value(w);
+            }
+        }
+
+        template<typename T, size_t Index, size_t I>
+        void write_tagged_field(io::Writer auto &w, const T &v, context_like auto &ctx) {
+            static constexpr const auto &field = std::get<I>(std::get<Index>(schema::SchemaSet<T>::schemas).fields);
+            using F = std::tuple_element_t<I, entry_fields_t<T, Index> >;
+            using S = serialize::Serializer<typename F::field_type, typename F::protocol>;
+            constexpr wire_type wt = wire_type_of<typename F::field_type, typename F::protocol>();
+
+            write_varint(w, tagged_field_ids<T, Index>()[I] << 3 | static_cast<size_t>(wt));
+            if constexpr (wt == wire_type::length)
+                write_sized(w, [&](auto &out) { S::write(out, v.*(field.ptr), ctx); });
+            else
+                S::write(w, v.*(field.ptr), ctx);
+        }
+
+        template<typename T, size_t Index, size_t I, typename R>
+        void read_tagged_field(R &r, T &out, context_like auto &ctx, const wire_type wt) {
+            static constexpr const auto &field = std::get<I>(std::get<Index>(schema::SchemaSet<T>::schemas).fields);
+            using F = std::tuple_element_t<I, entry_fields_t<T, Index> >;
+            using S = serialize::Serializer<typename F::field_type, typename F::protocol>;
+            constexpr wire_type expected = wire_type_of<typename F::field_type, typename F::protocol>();
+
+            if (wt != expected) {
+                if (detail::checks(ctx, errors::error_policy::MEDIUM))
+                    return detail::fail(ctx, errors::code::invalid_index, [&] {
+                        return errors::make(errors::code::invalid_index, ctx,
+                                            concat("wire type ", static_cast<int>(wt), " of field \"", field.name,
+                                                   "\" does not match expected ", static_cast<int>(expected)));
+                    });
+                return skip_wire(r, wt, ctx);
+            }
+
+            if constexpr (expected == wire_type::length) {
+                const size_t len = read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                io::LimitedReader limited_r(r, len);
+                S::read(limited_r, out.*(field.ptr), ctx);
+                if (limited_r.remaining != 0 && detail::checks(ctx, errors::error_policy::STRICT))
+                    return detail::fail(ctx, errors::code::fixed_size_mismatch, [&] {
+                        return errors::make(errors::code::fixed_size_mismatch, ctx,
+                                            concat("field left ", limited_r.remaining, " of ", len, " bytes unread"));
+                    });
+                limited_r.skip_remaining();
+            } else {
+                S::read(r, out.*(field.ptr), ctx);
+            }
+        }
+
+        // --- Skipping Values -------------------------------------------------
+        // 跳过值
+
+        template<typename P>
+        struct is_schema_proto : std::false_type {
+        };
+
+        template<size_t V>
+        struct is_schema_proto<proto::Schema<V> > : std::true_type {
+            static constexpr size_t version = V;
+        };
+
+        template<typename T>
+        struct is_string : std::false_type {
+        };
+
+        template<typename A>
+        struct is_string<std::basic_string<char, std::char_traits<char>, A> > : std::true_type {
+        };
+
+        template<typename T>
+        struct is_fixed_vector : std::false_type {
+        };
+
+        template<typename T, typename A>
+        struct is_fixed_vector<std::vector<T, A> >
+            : std::bool_constant<fixed_width<T, proto::Default> && !std::is_same_v<T, bool> > {
+        };
+
+        template<typename T, size_t Index, size_t I>
+        void skip_fields_from(io::Reader auto &r, context_like auto &ctx);
+
+        // Skips one T-P value as cheaply as its encoding permits:
+        // fixed-width values by offset, length-prefixed data without allocating, the rest by decoding.
+        template<typename T, typename Proto>
+        void skip_value(io::Reader auto &r, context_like auto &ctx) {
+            using P = std::conditional_t<std::is_same_v<Proto, proto::Default>, proto::DefaultProtocol_t<T>, Proto>;
+            const bool overflow_error = detail::checks(ctx, errors::error_policy::MEDIUM);
+
+            if constexpr (fixed_width<T, Proto>) {
+                skip_bytes(r, fixed_wire<T, Proto>::size);
+            } else if constexpr (std::integral<T> && std::is_same_v<P, proto::Varint>) {
+                (void) read_varint<uint64_t>(r, overflow_error);
+            } else if constexpr ((is_string<T>::value || std::is_same_v<T, types::bytes> ||
+                                  std::is_same_v<T, types::slice>) &&
+                                 std::is_same_v<P, proto::Varint>) {
+                skip_bytes(r, read_varint<size_t>(r, overflow_error));
+            } else if constexpr (is_fixed_vector<T>::value && std::is_same_v<P, proto::Varint>) {
+                constexpr size_t size = fixed_wire<typename T::value_type, proto::Default>::size;
+                const size_t count = read_varint<size_t>(r, overflow_error);
+                if (count > SIZE_MAX / size)
+                    return detail::fail(ctx, errors::code::container_too_large,
+                                        [&] { return errors::container_too_large(count, ctx); });
+                skip_bytes(r, count * size);
+            } else if constexpr (types::schema_serializable<T> && is_schema_proto<P>::value) {
+                skip_fields_from<T, schema::match_schema_index<T, is_schema_proto<P>::version>(), 0>(r, ctx);
+            } else {
+                T discarded{};
+                serialize::Serializer<T, Proto>::read(r, discarded, ctx);
+            }
+        }
+
+        template<typename T, size_t Index, size_t I>
+        void skip_fields_from(io::Reader auto &r, context_like auto &ctx) {
+            using Fields = entry_fields_t<T, Index>;
+
+            if constexpr (I < std::tuple_size_v<Fields>) {
+                constexpr size_t end = fixed_run_end<T, Index, I>();
+                if constexpr (end != I) {
+                    skip_bytes(r, fixed_run_size<T, Index, I, end>());
+                    skip_fields_from<T, Index, end>(r, ctx);
+                } else {
+                    skip_value<
+                        typename std::tuple_element_t<I, Fields>::field_type,
+                        typename std::tuple_element_t<I, Fields>::protocol
+                    >(r, ctx);
+                    skip_fields_from<T, Index, I + 1>(r, ctx);
+                }
+            }
+        }
+
+        // --- Chunked Containers ----------------------------------------------
+        // 分块容器
+
+        // Runs fn(c, chunk_ctx) for chunks [0, n), concurrently on ctx.opt.pool when there is one.
+        // Every chunk gets its own context, the traceback of the first failing chunk is moved into ctx.
+        // Errors reported as codes (try_read / try_write) keep chunks on this thread.
+        // So does a memory resource, which need not be thread-safe.
+        template<typename Fn>
+        void run_chunks(context_like auto &ctx, const size_t n, Fn &&fn) {
+            if (ctx.opt.pool == nullptr || n <= 1 || ctx.st.failure != nullptr || ctx.opt.resource != nullptr) {
+                for (size_t c = 0; c < n; ++c) fn(c, ctx);
+                return;
+            }
+
+            using C = std::remove_reference_t<decltype(ctx)>;
+            std::vector<C> locals(n, C{ctx.sf, ctx.opt, ctx.st, nullptr});
+            std::vector<uint8_t> failed(n);
+            BSP_TRY {
+                ctx.opt.pool->parallel_for(n, [&](const size_t c) {
+                    BSP_TRY {
+                        fn(c, locals[c]);
+                    } BSP_CATCH_ALL {
+                        failed[c] = 1;
+                        BSP_RETHROW;
+                    }
+                });
+            } BSP_CATCH_ALL {
+                // parallel_for rethrows the error of the lowest failing chunk
+                for (size_t c = 0; c < n; ++c)
+                    if (failed[c]) {
+                        ctx.traceback = std::move(locals[c].traceback);
+                        break;
+                    }
+                BSP_RETHROW;
+            }
+        }
+
+        struct chunk_entry {
+            size_t length; // Elements
+            size_t bytes;
+        };
+
+        // [Varint chunk count]([Varint chunk length][Varint chunk bytes])...
+        inline std::vector<chunk_entry> read_chunk_directory(io::Reader auto &r, const size_t size,
+                                                             context_like auto &ctx) {
+            const bool overflow_error = detail::checks(ctx, errors::error_policy::MEDIUM);
+            const size_t chunks = read_varint<size_t>(r, overflow_error);
+            if (chunks > size) {
+                fail(ctx, errors::code::invalid_index, [&] {
+                    return errors::make(errors::code::invalid_index, ctx,
+                                        concat(chunks, " chunks for ", size, " elements"));
+                });
+                return {};
+            }
+
+            std::vector<chunk_entry> directory(chunks);
+            size_t total = 0;
+            for (auto &[length, bytes]: directory) {
+                length = read_varint<size_t>(r, overflow_error);
+                bytes = read_varint<size_t>(r, overflow_error);
+                // Checked per entry, a wrapped sum could otherwise match size
+                if (length > size - total) {
+                    fail(ctx, errors::code::fixed_size_mismatch, [&] {
+                        return errors::make(errors::code::fixed_size_mismatch, ctx,
+                                            concat("chunk directory holds more than ", size, " elements"));
+                    });
+                    return {};
+                }
+                total += length;
+            }
+            if (total != size) {
+                fail(ctx, errors::code::fixed_size_mismatch, [&] {
+                    return errors::make(errors::code::fixed_size_mismatch, ctx,
+                                        concat("chunk directory holds ", total, " of ", size, " elements"));
+                });
+                return {};
+            }
+            return directory;
+        }
+
+        inline void write_chunk_directory(io::Writer auto &w, const std::vector<io::BufferWriter> &buffers,
+                                          const size_t size, const size_t chunk_size) {
+            write_varint(w, buffers.size());
+            for (size_t c = 0; c < buffers.size(); ++c) {
+                write_varint(w, std::min(chunk_size, size - c * chunk_size));
+                write_varint(w, buffers[c].buf.size());
+            }
+        }
+
+        // Decodes every chunk with decode(reader, chunk index, first element, chunk context).
+        // With a pool, the payload is taken as one block and chunks are decoded concurrently,
+        // otherwise chunks are read one after another from r.
+        template<typename Decode>
+        void read_chunks(io::Reader auto &r, const std::vector<chunk_entry> &directory, context_like auto &ctx,
+                         Decode &&decode) {
+            std::vector<size_t> firsts(directory.size());
+            std::vector<size_t> offsets(directory.size());
+            size_t payload = 0;
+            for (size_t c = 0, first = 0; c < directory.size(); ++c) {
+                firsts[c] = first;
+                offsets[c] = payload;
+                first += directory[c].length;
+                if (directory[c].bytes > SIZE_MAX - payload)
+                    return detail::fail(ctx, errors::code::container_too_large, [&] {
+                        return errors::make(errors::code::container_too_large, ctx, "chunk payload overflows size_t");
+                    });
+                payload += directory[c].bytes;
+            }
+
+            auto check = [&ctx](const size_t left, const size_t c) {
+                if (left != 0 && detail::checks(ctx, errors::error_policy::STRICT))
+                    return detail::fail(ctx, errors::code::fixed_size_mismatch, [&] {
+                        return errors::make(errors::code::fixed_size_mismatch, ctx,
+                                            concat("chunk ", c, " left ", left, " bytes unread"));
+                    });
+            };
+
+            if (ctx.opt.pool == nullptr || directory.size() <= 1 || ctx.st.failure != nullptr) {
+                for (size_t c = 0; c < directory.size(); ++c) {
+                    io::LimitedReader limited_r(r, directory[c].bytes);
+                    decode(limited_r, c, firsts[c], ctx);
+                    check(limited_r.remaining, c);
+                    limited_r.skip_remaining();
+                }
+                return;
+            }
+
+            using R = std::remove_cvref_t<decltype(r)>;
+            if constexpr (io::SizedReader<R>) {
+                if (payload > r.remaining())
+                    return detail::fail(ctx, errors::code::unexpected_eof, [&] {
+                        return errors::unexpected_eof(payload, r.remaining(), "chunk payload");
+                    });
+            }
+
+            std::vector<uint8_t> staging;
+            const uint8_t *data;
+            if constexpr (io::ContiguousReader<R> && io::SizedReader<R>) {
+                // Bounds already checked, so the payload is never staged beyond the input
+                data = r.borrow_bytes(payload);
+            } else {
+                // Grown as bytes arrive, so a forged directory cannot allocate more than the input holds
+                constexpr size_t staging_step = 64 * 1024;
+                for (size_t at = 0; at < payload;) {
+                    const size_t n = std::min(payload - at, staging_step);
+                    staging.resize(at + n);
+                    r.read_bytes(staging.data() + at, static_cast<std::streamsize>(n));
+                    at += n;
+                }
+                data = staging.data();
+            }
+
+            run_chunks(ctx, directory.size(), [&](const size_t c, auto &chunk_ctx) {
+                io::BytesReader chunk_r(data + offsets[c], directory[c].bytes);
+                decode(chunk_r, c, firsts[c], chunk_ctx);
+                check(directory[c].bytes - chunk_r.pos, c);
+            });
+        }
+
+        // --- Bit-Packed Offsets ----------------------------------------------
+        // 位压缩偏移表
+
+        // Offsets are packed LSB first with bit_width(payload size) bits each.
+        // Widths are capped so that one value never spans more than 8 bytes.
+        inline constexpr unsigned max_packed_width = 56;
+
+        [[nodiscard]] constexpr size_t packed_bytes(const size_t n, const unsigned width) {
+            return (n * width + 7) / 8;
+        }
+
+        inline void store_packed(uint8_t *table, const size_t i, const unsigned width, uint64_t v) {
+            size_t bit = i * width;
+            for (unsigned left = width; left;) {
+                const unsigned shift = bit % 8;
+                const unsigned k = std::min(left, 8 - shift);
+                table[bit / 8] |= static_cast<uint8_t>((v & ((1u << k) - 1)) << shift);
+                v >>= k;
+                bit += k;
+                left -= k;
+            }
+        }
+
+        [[nodiscard]] inline uint64_t load_packed(const uint8_t *table, const size_t i, const unsigned width) {
+            const size_t bit = i * width;
+            const unsigned shift = bit % 8;
+            const size_t n = (shift + width + 7) / 8;
+            uint64_t v = 0;
+            for (size_t k = 0; k < n; ++k)
+                v |= static_cast<uint64_t>(table[bit / 8 + k]) << (8 * k);
+            return (v >> shift) & ((uint64_t{1} << width) - 1);
+        }
+
+        // --- Field Projection ------------------------------------------------
+        // 字段投影
+
+        template<auto Member, typename Field>
+        consteval bool is_member(const Field &field) {
+            if constexpr (std::is_same_v<decltype(Member), decltype(field.ptr)>)
+                return field.ptr == Member;
+            else
+                return false;
+        }
+
+        template<typename T, size_t Index, size_t I, auto... Members>
+        consteval bool is_projected() {
+            constexpr const auto &field = std::get<I>(std::get<Index>(schema::SchemaSet<T>::schemas).fields);
+            return (is_member<Members>(field) || ...);
+        }
+
+        template<typename T, size_t Index, auto Member>
+        consteval bool in_schema() {
+            return []<size_t... Is>(std::index_sequence<Is...>) {
+                return (is_member<Member>(std::get<Is>(std::get<Index>(schema::SchemaSet<T>::schemas).fields)) || ...);
+            }(std::make_index_sequence<std::tuple_size_v<entry_fields_t<T, Index> > >{});
+        }
+
+        // End of the run of skipped fixed-width fields starting at I
+        template<typename T, size_t Index, size_t I, auto... Members>
+        consteval size_t skip_run_end() {
+            using Fields = entry_fields_t<T, Index>;
+            if constexpr (I >= std::tuple_size_v<Fields>) {
+                return I;
+            } else if constexpr (!is_projected<T, Index, I, Members...>() &&
+                                 fixed_width<typename std::tuple_element_t<I, Fields>::field_type,
+                                     typename std::tuple_element_t<I, Fields>::protocol>) {
+                return skip_run_end<T, Index, I + 1, Members...>();
+            } else {
+                return I;
+            }
+        }
+
+        template<typename T, size_t Index, size_t I, auto... Members>
+        void project_fields_from(io::Reader auto &r, T &out, context_like auto &ctx, const char *&current_field) {
+            static constexpr const auto &fields = std::get<Index>(schema::SchemaSet<T>::schemas).fields;
+            using Fields = entry_fields_t<T, Index>;
+
+            if constexpr (I < std::tuple_size_v<Fields>) {
+                using F = std::tuple_element_t<I, Fields>;
+                constexpr size_t end = skip_run_end<T, Index, I, Members...>();
+                current_field = std::get<I>(fields).name;
+
+                if constexpr (end != I) {
+                    skip_bytes(r, fixed_run_size<T, Index, I, end>());
+                    project_fields_from<T, Index, end, Members...>(r, out, ctx, current_field);
+                } else {
+                    if constexpr (is_projected<T, Index, I, Members...>())
+                        serialize::Serializer<typename F::field_type, typename F::protocol>::read(
+                            r, out.*(std::get<I>(fields).ptr), ctx);
+                    else
+                        skip_value<typename F::field_type, typename F::protocol>(r, ctx);
+                    project_fields_from<T, Index, I + 1, Members...>(r, out, ctx, current_field);
+                }
+            }
+        }
+
+        // --- Columns ---------------------------------------------------------
+        // 列
+
+        template<typename T, size_t Index, auto Member>
+        consteval size_t member_index() {
+            static_assert(in_schema<T, Index, Member>(), "bsp: member is not in the schema");
+            constexpr auto hits = []<size_t... Is>(std::index_sequence<Is...>) {
+                return std::array<bool, sizeof...(Is)>{
+                    is_member<Member>(std::get<Is>(std::get<Index>(schema::SchemaSet<T>::schemas).fields))...
+                };
+            }(std::make_index_sequence<std::tuple_size_v<entry_fields_t<T, Index> > >{});
+            for (size_t i = 0; i < hits.size(); ++i)
+                if (hits[i]) return i;
+            return SIZE_MAX;
+        }
+
+        template<typename Fields>
+        struct column_tuple;
+
+        template<typename... Fs>
+        struct column_tuple<std::tuple<Fs...> > {
+            using type = std::tuple<std::vector<typename Fs::field_type>...>;
+        };
+
+        // Writes field I of n rows as one column
+        template<typename T, size_t Index, size_t I>
+        void write_row_column(io::Writer auto &w, const T *rows, const size_t n, context_like auto &ctx) {
+            static constexpr const auto &field = std::get<I>(std::get<Index>(schema::SchemaSet<T>::schemas).fields);
+            using F = std::tuple_element_t<I, entry_fields_t<T, Index> >;
+            using V = typename F::field_type;
+
+            if constexpr (fixed_width<V, typename F::protocol>) {
+                write_fixed_each<V, typename F::protocol>(
+                    w, n, [rows](const size_t i) -> const V & { return rows[i].*(field.ptr); });
+            } else {
+                for (size_t i = 0; i < n; ++i)
+                    serialize::Serializer<V, typename F::protocol>::write(w, rows[i].*(field.ptr), ctx);
+            }
+        }
+
+        template<typename T, size_t Index, size_t I>
+        void read_row_column(io::Reader auto &r, T *rows, const size_t n, context_like auto &ctx) {
+            static constexpr const auto &field = std::get<I>(std::get<Index>(schema::SchemaSet<T>::schemas).fields);
+            using F = std::tuple_element_t<I, entry_fields_t<T, Index> >;
+            using V = typename F::field_type;
+
+            if constexpr (fixed_width<V, typename F::protocol>) {
+                read_fixed_each<V, typename F::protocol>(
+                    r, n, ctx, [rows](const size_t i) -> V & { return rows[i].*(field.ptr); });
+            } else {
+                for (size_t i = 0; i < n; ++i)
+                    serialize::Serializer<V, typename F::protocol>::read(r, rows[i].*(field.ptr), ctx);
+            }
+        }
+
+        // Columns held as std::vector, fixed-width ones go through the array paths
+        template<typename V, typename P>
+        void write_column(io::Writer auto &w, const std::vector<V> &column, context_like auto &ctx) {
+            if constexpr (fixed_width<V, P> && !std::is_same_v<V, bool>) {
+                write_fixed_array<V, P>(w, column.data(), column.size());
+            } else {
+                for (const V &value: column)
+                    serialize::Serializer<V, P>::write(w, value, ctx);
+            }
+        }
+
+        template<typename V, typename P>
+        void read_column(io::Reader auto &r, std::vector<V> &column, const size_t n, context_like auto &ctx) {
+            column.resize(n);
+            if constexpr (fixed_width<V, P> && !std::is_same_v<V, bool>) {
+                read_fixed_array<V, P>(r, column.data(), n, ctx);
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    V value{};
+                    serialize::Serializer<V, P>::read(r, value, ctx);
+                    column[i] = std::move(value);
+                }
+            }
+        }
+
+        // --- Memory Resources ------------------------------------------------
+        // 内存资源
+
+        // Moves a pmr container still on the default resource to ctx.opt.resource before it is read into,
+        // its elements then follow it through uses-allocator construction. The old contents are discarded.
+        template<typename T>
+        void adopt_resource(T &out, const context_like auto &ctx) {
+            if constexpr (std::is_same_v<typename T::allocator_type,
+                std::pmr::polymorphic_allocator<typename T::value_type> >) {
+                if (ctx.opt.resource != nullptr && out.get_allocator().resource() == std::pmr::get_default_resource()) {
+                    std::destroy_at(&out);
+                    std::construct_at(&out, typename T::allocator_type(ctx.opt.resource));
+                }
+            }
+        }
+
+        // A key or element to be moved into out, on the allocator of out when it takes one
+        template<typename T, typename Container>
+        T make_element(const Container &out) {
+            return std::make_obj_using_allocator<T>(out.get_allocator());
+        }
+    }
+
+    // === Serializers =========================================================
+    // 序列化器特化实现
+    namespace serialize {
+        // ~~~ Serializers for Types ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+        // 为特定类型设计的序列化器
+
+        // --- Serializers for Value Types  ------------------------------------
+        // 数据类型的序列化器
+        // bool
+        // [0/1 Bool]
+        template<>
+        struct Serializer<bool, proto::Fixed<> > {
+            static void write(io::Writer auto &w, const bool &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame("bool", "Fixed<>"); }, [&] {
+                    w.write_byte(v);
+                });
+            }
+
+            static void read(io::Reader auto &r, bool &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame("bool", "Fixed<>"); }, [&] {
+                    if (detail::checks(ctx, errors::error_policy::STRICT)) {
+                        const uint8_t b = r.read_byte();
+                        if (b > 1)
+                            return detail::fail(ctx, errors::code::invalid_bool,
+                                                [&] { return errors::invalid_bool(b, ctx); });
+                        out = b;
+                    } else {
+                        out = r.read_byte();
+                    }
+                });
+            }
+        };
+
+        // Integral
+        template<std::integral T>
+        struct Serializer<T, proto::Fixed<> > {
+            static constexpr const char *t_str = detail::type_name_of<T>();
+
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Fixed<>"); }, [&] {
+                    const auto x = detail::adapt_endian(v);
+                    w.write_bytes(reinterpret_cast<const uint8_t *>(&x), sizeof(T));
+                });
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Fixed<>"); }, [&] {
+                    T x;
+                    r.read_bytes(reinterpret_cast<uint8_t *>(&x), sizeof(T));
+                    out = detail::adapt_endian(x);
+                });
+            }
+        };
+
+        // [LEB128 Varint]
+        // Not affected by endian
+        template<std::unsigned_integral T>
+        struct Serializer<T, proto::Varint> {
+            static constexpr const char *t_str = detail::type_name_of<T>();
+
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Varint"); }, [&] {
+                    detail::write_varint(w, v);
+                });
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Varint"); }, [&] {
+                    out = detail::read_varint<T>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                });
+            }
+        };
+
+        // [ZigZag+LEB128 Varint]
+        // Not affected by endian
+        template<std::signed_integral T>
+        struct Serializer<T, proto::Varint> {
+            static constexpr const char *t_str = detail::type_name_of<T>();
+
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Varint"); }, [&] {
+                    detail::write_varint(w, detail::zigzag_encode(v));
+                });
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Varint"); }, [&] {
+                    out = detail::zigzag_decode(detail::read_varint<std::make_unsigned_t<T> >(
+                        r, detail::checks(ctx, errors::error_policy::MEDIUM)));
+                });
+            }
+        };
+
+        // Floating
+        template<std::floating_point T> requires std::numeric_limits<T>::is_iec559
+        struct Serializer<T, proto::Fixed<> > {
+            using U = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+            static constexpr const char *t_str = detail::type_name_of<T>();
+
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Fixed<>"); }, [&] {
+                    const U x = detail::adapt_endian(std::bit_cast<U>(v));
+                    w.write_bytes(reinterpret_cast<const uint8_t *>(&x), sizeof(T));
+                });
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Fixed<>"); }, [&] {
+                    U x;
+                    r.read_bytes(reinterpret_cast<uint8_t *>(&x), sizeof(T));
+                    out = std::bit_cast<T>(detail::adapt_endian(x));
+                });
+            }
+        };
+
+
+        // --- Serializers for Container Types ---------------------------------
+        // 容器类型的序列化器
+        // std::string
+        // [Varint length][String]
+        template<typename A>
+        struct Serializer<std::basic_string<char, std::char_traits<char>, A>, proto::Varint> {
+            using string_type = std::basic_string<char, std::char_traits<char>, A>;
+
+            static void write(io::Writer auto &w, const string_type &v, context_like auto &ctx) {
+                ctx.leaf([&] {
+                    return errors::value_frame{
+                        "std::string", "Varint", {},
+                        errors::frame_text{"length=", v.size()}
+                    };
+                }, [&] {
+                    detail::write_varint(w, v.size());
+                    detail::write_payload(w, v.data(), v.size());
+                });
+            }
+
+            static void read(io::Reader auto &r, string_type &out, context_like auto &ctx) {
+                size_t size = 0;
+                ctx.leaf([&] {
+                    return errors::value_frame{
+                        "std::string", "Varint", {},
+                        errors::frame_text{"length=", size}
+                    };
+                }, [&] {
+                    size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+
+                    if (detail::limits(ctx))
+                        if (size > ctx.sf.max_string_size)
+                            return detail::fail(ctx, errors::code::string_too_large,
+                                                [&] { return errors::string_too_large(size, ctx); });
+
+                    detail::adopt_resource(out, ctx);
+                    out.resize(size);
+                    r.read_bytes(reinterpret_cast<uint8_t *>(out.data()), size);
+                });
+            }
+        };
+
+        // [String]
+        template<size_t N>
+        struct Serializer<std::string, proto::Fixed<N> > {
+            static errors::frame_text p_str() { return {"Fixed<", N, ">"}; }
+
+            static void write(io::Writer auto &w, const std::string &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame("std::string", p_str()); }, [&] {
+                    if (v.size() != N)
+                        return detail::fail(ctx, errors::code::fixed_size_mismatch,
+                                            [&] { return errors::fixed_size_mismatch(N, v.size(), ctx); });
+
+                    detail::write_payload(w, v.data(), v.size());
+                });
+            }
+
+            static void read(io::Reader auto &r, std::string &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame("std::string", p_str()); }, [&] {
+                    out.resize(N);
+                    r.read_bytes(reinterpret_cast<uint8_t *>(out.data()), N);
+                });
+            }
+        };
+
+        // types::bytes (std::vector<uint8_t>)
+        // [Varint length][Bytearray]
+        template<>
+        struct Serializer<types::bytes, proto::Varint> {
+            static void write(io::Writer auto &w, const types::bytes &v, context_like auto &ctx) {
+                ctx.leaf([&] {
+                    return errors::value_frame{
+                        "types::bytes", "Varint", {},
+                        errors::frame_text{"length=", v.size()}
+                    };
+                }, [&] {
+                    detail::write_varint(w, v.size());
+                    detail::write_payload(w, v.data(), v.size());
+                });
+            }
+
+            static void read(io::Reader auto &r, types::bytes &out, context_like auto &ctx) {
+                size_t size = 0;
+                ctx.leaf([&] {
+                    return errors::value_frame{
+                        "types::bytes", "Varint", {},
+                        errors::frame_text{"length=", size}
+                    };
+                }, [&] {
+                    size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+
+                    if (detail::limits(ctx))
+                        if (size > ctx.sf.max_string_size)
+                            return detail::fail(ctx, errors::code::string_too_large,
+                                                [&] { return errors::string_too_large(size, ctx); });
+
+                    out.resize(size);
+                    r.read_bytes(out.data(), size);
+                });
+            }
+        };
+
+        // types::slice
+        // [Varint length][Bytearray], shares the input buffer when the reader is a SharingReader
+        template<>
+        struct Serializer<types::slice, proto::Varint> {
+            static void write(io::Writer auto &w, const types::slice &v, context_like auto &ctx) {
+                ctx.leaf([&] {
+                    return errors::value_frame{
+                        "types::slice", "Varint", {},
+                        errors::frame_text{"length=", v.size()}
+                    };
+                }, [&] {
+                    detail::write_varint(w, v.size());
+                    detail::write_payload(w, v.data(), v.size());
+                });
+            }
+
+            static void read(io::Reader auto &r, types::slice &out, context_like auto &ctx) {
+                size_t size = 0;
+                ctx.leaf([&] {
+                    return errors::value_frame{
+                        "types::slice", "Varint", {},
+                        errors::frame_text{"length=", size}
+                    };
+                }, [&] {
+                    size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+
+                    if (detail::limits(ctx))
+                        if (size > ctx.sf.max_string_size)
+                            return detail::fail(ctx, errors::code::string_too_large,
+                                                [&] { return errors::string_too_large(size, ctx); });
+
+                    if constexpr (io::SharingReader<std::remove_cvref_t<decltype(r)> >) {
+                        out = r.borrow_slice(size);
+                    } else {
+                        types::bytes buf(size);
+                        r.read_bytes(buf.data(), static_cast<std::streamsize>(size));
+                        out = types::slice::adopt(std::move(buf));
+                    }
+                });
+            }
+        };
+
+        // [Bytearray]
+        template<size_t N>
+        struct Serializer<types::bytes, proto::Fixed<N> > {
+            static errors::frame_text p_str() { return {"Fixed<", N, ">"}; }
+
+            static void write(io::Writer auto &w, const types::bytes &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame("types::bytes", p_str()); }, [&] {
+                    if (v.size() != N)
+                        return detail::fail(ctx, errors::code::fixed_size_mismatch,
+                                            [&] { return errors::fixed_size_mismatch(N, v.size(), ctx); });
+                    detail::write_payload(w, v.data(), v.size());
+                });
+            }
+
+            static void read(io::Reader auto &r, types::bytes &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame("types::bytes", p_str()); }, [&] {
+                    out.resize(N);
+                    r.read_bytes(out.data(), N);
+                });
+            }
+        };
+
+        // std::vector
+        // [Varint length][Value 0][Value 1]...
+        template<typename T, typename A> requires types::default_serializable<T>
+        struct Serializer<std::vector<T, A>, proto::Varint> {
+            static void write(io::Writer auto &w, const std::vector<T, A> &v, context_like auto &ctx) {
+                size_t index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::vector", "Varint", errors::frame_text{"Elem ", index},
+                        errors::frame_text{"length=", v.size()}
+                    };
+                });
+                detail::write_varint(w, v.size());
+
+                if constexpr (detail::fixed_width<T, proto::Default> && !std::is_same_v<T, bool>) {
+                    detail::write_fixed_array<T, proto::Default>(w, v.data(), v.size());
+                } else {
+                    for (; index < v.size(); ++index) {
+                        DefaultSerializer<T>::write(w, v[index], ctx);
+                    }
+                }
+            }
+
+            static void read(io::Reader auto &r, std::vector<T, A> &out, context_like auto &ctx) {
+                size_t index = 0;
+                size_t size = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::vector", "Varint", errors::frame_text{"Elem ", index},
+                        errors::frame_text{"length=", size}
+                    };
+                });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+
+                detail::adopt_resource(out, ctx);
+                out.resize(size);
+                if constexpr (detail::fixed_width<T, proto::Default> && !std::is_same_v<T, bool>) {
+                    detail::read_fixed_array<T, proto::Default>(r, out.data(), size, ctx);
+                } else {
+                    for (; index < size; ++index) {
+                        DefaultSerializer<T>::read(r, out[index], ctx);
+                    }
+                }
+            }
+        };
+
+        // Chunked
+        // [Varint length][Chunk directory][Chunk 0][Chunk 1]..., each chunk is [Value i][Value i+1]...
+        template<typename T, typename Inner> requires types::serializable<T, Inner>
+        struct Serializer<std::vector<T>, proto::Chunked<Inner> > {
+            static void write(io::Writer auto &w, const std::vector<T> &v, context_like auto &ctx) {
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::vector", "Chunked", {}, errors::frame_text{"length=", v.size()}
+                    };
+                });
+
+                const size_t chunk_size = std::max<size_t>(1, ctx.opt.chunk_size);
+                std::vector<io::BufferWriter> buffers((v.size() + chunk_size - 1) / chunk_size);
+                detail::run_chunks(ctx, buffers.size(), [&](const size_t c, auto &chunk_ctx) {
+                    const size_t end = std::min(v.size(), (c + 1) * chunk_size);
+                    for (size_t i = c * chunk_size; i < end; ++i)
+                        Serializer<T, Inner>::write(buffers[c], v[i], chunk_ctx);
+                });
+
+                detail::write_varint(w, v.size());
+                detail::write_chunk_directory(w, buffers, v.size(), chunk_size);
+                for (const auto &b: buffers)
+                    w.write_bytes(b.buf.data(), static_cast<std::streamsize>(b.buf.size()));
+            }
+
+            static void read(io::Reader auto &r, std::vector<T> &out, context_like auto &ctx) {
+                size_t size = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::vector", "Chunked", {}, errors::frame_text{"length=", size}
+                    };
+                });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+                const auto directory = detail::read_chunk_directory(r, size, ctx);
+
+                // Pre-sized, chunks decode into disjoint ranges
+                out.resize(size);
+                detail::read_chunks(r, directory, ctx, [&](auto &chunk_r, const size_t c, const size_t first,
+                                                           auto &chunk_ctx) {
+                    for (size_t i = first; i < first + directory[c].length; ++i)
+                        Serializer<T, Inner>::read(chunk_r, out[i], chunk_ctx);
+                });
+            }
+        };
+
+        // [Varint length][Chunk directory][Chunk 0][Chunk 1]..., each chunk is [Key i][Value i]...
+        template<typename K, typename V, typename Inner> requires (types::default_serializable<K> &&
+                                                                   types::serializable<V, Inner>)
+        struct Serializer<std::unordered_map<K, V>, proto::Chunked<Inner> > {
+            static void write(io::Writer auto &w, const std::unordered_map<K, V> &v, context_like auto &ctx) {
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::unordered_map", "Chunked", {}, errors::frame_text{"length=", v.size()}
+                    };
+                });
+
+                // Buckets cannot be split, so chunks index a flat list of entries
+                std::vector<const std::pair<const K, V> *> entries;
+                entries.reserve(v.size());
+                for (const auto &entry: v) entries.push_back(&entry);
+
+                const size_t chunk_size = std::max<size_t>(1, ctx.opt.chunk_size);
+                std::vector<io::BufferWriter> buffers((v.size() + chunk_size - 1) / chunk_size);
+                detail::run_chunks(ctx, buffers.size(), [&](const size_t c, auto &chunk_ctx) {
+                    const size_t end = std::min(entries.size(), (c + 1) * chunk_size);
+                    for (size_t i = c * chunk_size; i < end; ++i) {
+                        DefaultSerializer<K>::write(buffers[c], entries[i]->first, chunk_ctx);
+                        Serializer<V, Inner>::write(buffers[c], entries[i]->second, chunk_ctx);
+                    }
+                });
+
+                detail::write_varint(w, v.size());
+                detail::write_chunk_directory(w, buffers, v.size(), chunk_size);
+                for (const auto &b: buffers)
+                    w.write_bytes(b.buf.data(), static_cast<std::streamsize>(b.buf.size()));
+            }
+
+            static void read(io::Reader auto &r, std::unordered_map<K, V> &out, context_like auto &ctx) {
+                size_t size = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::unordered_map", "Chunked", {}, errors::frame_text{"length=", size}
+                    };
+                });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+                const auto directory = detail::read_chunk_directory(r, size, ctx);
+
+                // Entries are decoded concurrently, inserting into the map stays on this thread
+                std::vector<std::pair<K, V> > entries(size);
+                detail::read_chunks(r, directory, ctx, [&](auto &chunk_r, const size_t c, const size_t first,
+                                                           auto &chunk_ctx) {
+                    for (size_t i = first; i < first + directory[c].length; ++i) {
+                        DefaultSerializer<K>::read(chunk_r, entries[i].first, chunk_ctx);
+                        Serializer<V, Inner>::read(chunk_r, entries[i].second, chunk_ctx);
+                    }
+                });
+
+                out.clear();
+                out.reserve(size);
+                for (auto &[key, value]: entries) {
+                    if (detail::checks(ctx, errors::error_policy::STRICT))
+                        if (out.contains(key))
+                            return detail::fail(ctx, errors::code::duplicate_key, [&] {
+                                return errors::make(errors::code::duplicate_key, ctx,
+                                                    std::string("duplicate key in std::unordered_map"));
+                            });
+                    out.emplace(std::move(key), std::move(value));
+                }
+            }
+        };
+
+        // Struct of arrays
+        // [Varint length][Column of Field 1][Column of Field 2]...
+        template<typename T, size_t V> requires types::schema_serializable<T>
+        struct Serializer<std::vector<T>, proto::Columnar<V> > {
+            static constexpr size_t index = schema::match_schema_index<T, V>();
+            static_assert(index != SIZE_MAX, "bsp: no suitable schema under version V");
+
+            static constexpr const auto &fields = std::get<index>(schema::SchemaSet<T>::schemas).fields;
+            static constexpr size_t count = std::tuple_size_v<detail::entry_fields_t<T, index> >;
+
+            static errors::frame_text p_str() {
+                return V == SIZE_MAX ? errors::frame_text{"Columnar<MAX>"} : errors::frame_text{"Columnar<", V, ">"};
+            }
+
+            static void write(io::Writer auto &w, const std::vector<T> &v, context_like auto &ctx) {
+                const char *column = nullptr;
+                auto g = ctx.template guard<true, false, false>([&] { return frame(column, v.size()); });
+
+                detail::write_varint(w, v.size());
+                [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    ((column = std::get<Is>(fields).name,
+                      detail::write_row_column<T, index, Is>(w, v.data(), v.size(), ctx)), ...);
+                }(std::make_index_sequence<count>{});
+            }
+
+            static void read(io::Reader auto &r, std::vector<T> &out, context_like auto &ctx) {
+                const char *column = nullptr;
+                size_t size = 0;
+                auto g = ctx.template guard<true, false, false>([&] { return frame(column, size); });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+
+                out.resize(size);
+                [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    ((column = std::get<Is>(fields).name,
+                      detail::read_row_column<T, index, Is>(r, out.data(), size, ctx)), ...);
+                }(std::make_index_sequence<count>{});
+            }
+
+            static errors::value_frame frame(const char *column, const size_t size) {
+                return errors::value_frame{
+                    "std::vector", p_str(),
+                    column ? errors::frame_text{"Column \"", column, "\""} : errors::frame_text{},
+                    errors::frame_text{"length=", size}
+                };
+            }
+        };
+
+        // [Varint length][Column of Field 1][Column of Field 2]...
+        template<typename T, size_t V>
+        struct Serializer<columns<T, V>, proto::Columnar<V> > {
+            using Rows = Serializer<std::vector<T>, proto::Columnar<V> >;
+            using Fields = detail::entry_fields_t<T, Rows::index>;
+
+            static void write(io::Writer auto &w, const columns<T, V> &v, context_like auto &ctx) {
+                const char *column = nullptr;
+                const size_t size = v.size();
+                auto g = ctx.template guard<true, false, false>([&] { return Rows::frame(column, size); });
+
+                // Every column must hold size values, column is left at the first one that does not
+                size_t actual = size;
+                [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    (void) ((column = std::get<Is>(Rows::fields).name,
+                             actual = std::get<Is>(v.data).size(), actual == size) && ...);
+                }(std::make_index_sequence<Rows::count>{});
+                if (actual != size)
+                    return detail::fail(ctx, errors::code::fixed_size_mismatch,
+                                        [&] { return errors::fixed_size_mismatch(size, actual, ctx); });
+
+                detail::write_varint(w, size);
+                [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    ((column = std::get<Is>(Rows::fields).name,
+                      detail::write_column<
+                          typename std::tuple_element_t<Is, Fields>::field_type,
+                          typename std::tuple_element_t<Is, Fields>::protocol
+                      >(w, std::get<Is>(v.data), ctx)), ...);
+                }(std::make_index_sequence<Rows::count>{});
+            }
+
+            static void read(io::Reader auto &r, columns<T, V> &out, context_like auto &ctx) {
+                const char *column = nullptr;
+                size_t size = 0;
+                auto g = ctx.template guard<true, false, false>([&] { return Rows::frame(column, size); });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+
+                [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    ((column = std::get<Is>(Rows::fields).name,
+                      detail::read_column<
+                          typename std::tuple_element_t<Is, Fields>::field_type,
+                          typename std::tuple_element_t<Is, Fields>::protocol
+                      >(r, std::get<Is>(out.data), size, ctx)), ...);
+                }(std::make_index_sequence<Rows::count>{});
+            }
+        };
+
+        // Random access
+        // [Varint length][Varint payload size][Bit-packed offsets of Value 1..N-1][Value 0][Value 1]...
+        template<typename T, typename Inner> requires types::serializable<T, Inner>
+        struct Serializer<std::vector<T>, proto::Indexed<Inner> > {
+            static void write(io::Writer auto &w, const std::vector<T> &v, context_like auto &ctx) {
+                size_t index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::vector", "Indexed", errors::frame_text{"Elem ", index},
+                        errors::frame_text{"length=", v.size()}
+                    };
+                });
+
+                // Offsets are only known once the payload is encoded
+                io::BufferWriter payload;
+                std::vector<size_t> offsets;
+                offsets.reserve(v.size());
+                for (; index < v.size(); ++index) {
+                    offsets.push_back(payload.buf.size());
+                    Serializer<T, Inner>::write(payload, v[index], ctx);
+                }
+
+                const unsigned width = std::bit_width(payload.buf.size());
+                if (width > detail::max_packed_width)
+                    return detail::fail(ctx, errors::code::container_too_large, [&] {
+                        return errors::make(errors::code::container_too_large, ctx,
+                                            detail::concat("indexed payload of ", payload.buf.size(),
+                                                           " bytes is too large"));
+                    });
+
+                std::vector<uint8_t> table(v.empty() ? 0 : detail::packed_bytes(v.size() - 1, width));
+                for (size_t i = 1; i < offsets.size(); ++i)
+                    detail::store_packed(table.data(), i - 1, width, offsets[i]);
+
+                detail::write_varint(w, v.size());
+                detail::write_varint(w, payload.buf.size());
+                w.write_bytes(table.data(), static_cast<std::streamsize>(table.size()));
+                w.write_bytes(payload.buf.data(), static_cast<std::streamsize>(payload.buf.size()));
+            }
+
+            static void read(io::Reader auto &r, std::vector<T> &out, context_like auto &ctx) {
+                size_t index = 0;
+                size_t size = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::vector", "Indexed", errors::frame_text{"Elem ", index},
+                        errors::frame_text{"length=", size}
+                    };
+                });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+                const size_t payload_size = detail::read_varint<size_t>(
+                    r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                const unsigned width = std::bit_width(payload_size);
+                if (width > detail::max_packed_width)
+                    return detail::fail(ctx, errors::code::container_too_large, [&] {
+                        return errors::make(errors::code::container_too_large, ctx,
+                                            detail::concat("indexed payload of ", payload_size, " bytes is too large"));
+                    });
+
+                // Sequential reads only need the offsets to validate element boundaries
+                const size_t table_size = size == 0 ? 0 : detail::packed_bytes(size - 1, width);
+                std::vector<uint8_t> table;
+                if (detail::checks(ctx, errors::error_policy::STRICT)) {
+                    table.resize(table_size);
+                    r.read_bytes(table.data(), static_cast<std::streamsize>(table_size));
+                } else {
+                    detail::skip_bytes(r, table_size);
+                }
+
+                io::LimitedReader limited_r(r, payload_size);
+                out.resize(size);
+                for (; index < size; ++index) {
+                    if (!table.empty() && index != 0 &&
+                        payload_size - limited_r.remaining != detail::load_packed(table.data(), index - 1, width))
+                        return detail::fail(ctx, errors::code::fixed_size_mismatch, [&] {
+                            return errors::make(errors::code::fixed_size_mismatch, ctx,
+                                                "element boundary mismatches the offset table");
+                        });
+                    Serializer<T, Inner>::read(limited_r, out[index], ctx);
+                }
+
+                if (limited_r.remaining != 0 && detail::checks(ctx, errors::error_policy::STRICT))
+                    return detail::fail(ctx, errors::code::fixed_size_mismatch, [&] {
+                        return errors::make(errors::code::fixed_size_mismatch, ctx,
+                                            detail::concat("indexed payload left ", limited_r.remaining, " of ",
+                                                           payload_size, " bytes unread"));
+                    });
+                limited_r.skip_remaining();
+            }
+        };
+
+        // [Value 0][Value 1]...
+        template<typename T, size_t N> requires types::default_serializable<T>
+        struct Serializer<std::vector<T>, proto::Fixed<N> > {
+            static errors::frame_text p_str() { return {"Fixed<", N, ">"}; }
+
+            static void write(io::Writer auto &w, const std::vector<T> &v, context_like auto &ctx) {
+                size_t index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::vector", p_str(), errors::frame_text{"Elem ", index}
+                    };
+                });
+                if (v.size() != N)
+                    return detail::fail(ctx, errors::code::fixed_size_mismatch,
+                                        [&] { return errors::fixed_size_mismatch(N, v.size(), ctx); });
+
+                if constexpr (detail::fixed_width<T, proto::Default> && !std::is_same_v<T, bool>) {
+                    detail::write_fixed_array<T, proto::Default>(w, v.data(), N);
+                } else {
+                    for (; index < N; ++index) {
+                        DefaultSerializer<T>::write(w, v[index], ctx);
+                    }
+                }
+            }
+
+            static void read(io::Reader auto &r, std::vector<T> &out, context_like auto &ctx) {
+                size_t index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::vector", p_str(), errors::frame_text{"Elem ", index}
+                    };
+                });
+
+                out.resize(N);
+                if constexpr (detail::fixed_width<T, proto::Default> && !std::is_same_v<T, bool>) {
+                    detail::read_fixed_array<T, proto::Default>(r, out.data(), N, ctx);
+                } else {
+                    for (; index < N; ++index) {
+                        DefaultSerializer<T>::read(r, out[index], ctx);
+                    }
+                }
+            }
+        };
+
+        // Note: std::vector<bool> is not bit-compressed
+        // Use std::bitset or vector<bool> + Trivial if you want to enable bit-compression
+
+        // std::bitset
+        // Bit-compressed with Little-endian style
+        template<size_t N>
+        struct Serializer<std::bitset<N>, proto::Fixed<> > {
+            static constexpr size_t byte_count = (N + 7) / 8;
+
+            static errors::frame_text t_str() {
+                return {"std::bitset<", N, ">"};
+            }
+
+            static void write(io::Writer auto &w, const std::bitset<N> &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str(), "Fixed<>"); }, [&] {
+                    // Serialize as little-endian bytes
+                    for (size_t i = 0; i < byte_count; ++i) {
+                        uint8_t byte = 0;
+                        for (size_t bit = 0; bit < 8 && (i * 8 + bit) < N; ++bit) {
+                            if (v[i * 8 + bit])
+                                byte |= (1u << bit);
+                        }
+                        w.write_byte(byte);
+                    }
+                });
+            }
+
+            static void read(io::Reader auto &r, std::bitset<N> &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str(), "Fixed<>"); }, [&] {
+                    out.reset();
+                    for (size_t i = 0; i < byte_count; ++i) {
+                        const uint8_t byte = r.read_byte();
+                        for (size_t bit = 0; bit < 8 && (i * 8 + bit) < N; ++bit) {
+                            if (byte & (1u << bit))
+                                out.set(i * 8 + bit);
+                        }
+                    }
+                });
+            }
+        };
+
+        // std::map
+        // [Varint length][Key 1][Value 1][Key 2][Value 2]...
+        template<typename K, typename V, typename A> requires (types::default_serializable<K> &&
+                                                               types::default_serializable<V>)
+        struct Serializer<std::map<K, V, std::less<K>, A>, proto::Varint> {
+            using map_type = std::map<K, V, std::less<K>, A>;
+
+            static void write(io::Writer auto &w, const map_type &v, context_like auto &ctx) {
+                size_t index = 0;
+                bool is_value = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::map", "Varint", errors::frame_text{is_value ? "Value " : "Key ", index},
+                        errors::frame_text{"length=", v.size()}
+                    };
+                });
+
+                detail::write_varint(w, v.size());
+                for (const auto &[key, value]: v) {
+                    is_value = false;
+                    DefaultSerializer<K>::write(w, key, ctx);
+                    is_value = true;
+                    DefaultSerializer<V>::write(w, value, ctx);
+                    ++index;
+                }
+            }
+
+            static void read(io::Reader auto &r, map_type &out, context_like auto &ctx) {
+                size_t index = 0;
+                size_t size = 0;
+                [[maybe_unused]] bool is_value = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::map", "Varint", errors::frame_text{is_value ? "Value " : "Key ", index},
+                        errors::frame_text{"length=", size}
+                    };
+                });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+
+                detail::adopt_resource(out, ctx);
+                out.clear();
+                for (; index < size; index++) {
+                    is_value = false;
+                    K key = detail::make_element<K>(out);
+                    DefaultSerializer<K>::read(r, key, ctx);
+                    is_value = true;
+                    V value = detail::make_element<V>(out);
+                    DefaultSerializer<V>::read(r, value, ctx);
+
+                    if (detail::checks(ctx, errors::error_policy::STRICT))
+                        if (out.contains(key))
+                            return detail::fail(ctx, errors::code::duplicate_key, [&] {
+                                return errors::make(errors::code::duplicate_key, ctx,
+                                                    std::string("duplicate key in std::map"));
+                            });
+
+                    out.emplace(std::move(key), std::move(value));
+                }
+            }
+        };
+
+        // [Key 1][Value 1][Key 2][Value 2]...
+        template<typename K, typename V, size_t N> requires (types::default_serializable<K> &&
+                                                             types::default_serializable<V>)
+        struct Serializer<std::map<K, V>, proto::Fixed<N> > {
+            static errors::frame_text p_str() { return {"Fixed<", N, ">"}; }
+
+            static void write(io::Writer auto &w, const std::map<K, V> &v, context_like auto &ctx) {
+                size_t index = 0;
+                bool is_value = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::map", p_str(), errors::frame_text{is_value ? "Value " : "Key ", index}
+                    };
+                });
+                if (v.size() != N)
+                    return detail::fail(ctx, errors::code::fixed_size_mismatch,
+                                        [&] { return errors::fixed_size_mismatch(N, v.size(), ctx); });
+
+                for (const auto &[key, value]: v) {
+                    is_value = false;
+                    DefaultSerializer<K>::write(w, key, ctx);
+                    is_value = true;
+                    DefaultSerializer<V>::write(w, value, ctx);
+                    ++index;
+                }
+            }
+
+            static void read(io::Reader auto &r, std::map<K, V> &out, context_like auto &ctx) {
+                size_t index = 0;
+                [[maybe_unused]] bool is_value = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::map", p_str(), errors::frame_text{is_value ? "Value " : "Key ", index}
+                    };
+                });
+
+                out.clear();
+                for (; index < N; ++index) {
+                    is_value = false;
+                    K key;
+                    DefaultSerializer<K>::read(r, key, ctx);
+                    is_value = true;
+                    V value;
+                    DefaultSerializer<V>::read(r, value, ctx);
+
+                    if (detail::checks(ctx, errors::error_policy::STRICT))
+                        if (out.contains(key))
+                            return detail::fail(ctx, errors::code::duplicate_key, [&] {
+                                return errors::make(errors::code::duplicate_key, ctx,
+                                                    std::string("duplicate key in std::map"));
+                            });
+
+                    out.emplace(std::move(key), std::move(value));
+                }
+            }
+        };
+
+        // std::unordered_map
+        // [Varint length][Key 1][Value 1][Key 2][Value 2]...
+        template<typename K, typename V, typename A> requires (types::default_serializable<K> &&
+                                                               types::default_serializable<V>)
+        struct Serializer<std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, A>, proto::Varint> {
+            using map_type = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, A>;
+
+            static void write(io::Writer auto &w, const map_type &v, context_like auto &ctx) {
+                size_t index = 0;
+                bool is_value = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::unordered_map", "Varint", errors::frame_text{is_value ? "Value " : "Key ", index},
+                        errors::frame_text{"length=", v.size()}
+                    };
+                });
+
+                detail::write_varint(w, v.size());
+                for (const auto &[key, value]: v) {
+                    is_value = false;
+                    DefaultSerializer<K>::write(w, key, ctx);
+                    is_value = true;
+                    DefaultSerializer<V>::write(w, value, ctx);
+                    ++index;
+                }
+            }
+
+            static void read(io::Reader auto &r, map_type &out, context_like auto &ctx) {
+                size_t index = 0;
+                size_t size = 0;
+                [[maybe_unused]] bool is_value = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::unordered_map", "Varint", errors::frame_text{is_value ? "Value " : "Key ", index},
+                        errors::frame_text{"length=", size}
+                    };
+                });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+
+                detail::adopt_resource(out, ctx);
+                out.clear();
+                for (; index < size; ++index) {
+                    is_value = false;
+                    K key = detail::make_element<K>(out);
+                    DefaultSerializer<K>::read(r, key, ctx);
+                    is_value = true;
+                    V value = detail::make_element<V>(out);
+                    DefaultSerializer<V>::read(r, value, ctx);
+
+                    if (detail::checks(ctx, errors::error_policy::STRICT))
+                        if (out.contains(key))
+                            return detail::fail(ctx, errors::code::duplicate_key, [&] {
+                                return errors::make(errors::code::duplicate_key, ctx,
+                                                    std::string("duplicate key in std::unordered_map"));
+                            });
+
+                    out.emplace(std::move(key), std::move(value));
+                }
+            }
+        };
+
+        // [Key 1][Value 1][Key 2][Value 2]...
+        template<typename K, typename V, size_t N> requires (types::default_serializable<K> &&
+                                                             types::default_serializable<V>)
+        struct Serializer<std::unordered_map<K, V>, proto::Fixed<N> > {
+            static errors::frame_text p_str() { return {"Fixed<", N, ">"}; }
+
+            static void write(io::Writer auto &w, const std::unordered_map<K, V> &v, context_like auto &ctx) {
+                size_t index = 0;
+                bool is_value = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::unordered_map", p_str(), errors::frame_text{is_value ? "Value " : "Key ", index}
+                    };
+                });
+                if (v.size() != N)
+                    return detail::fail(ctx, errors::code::fixed_size_mismatch,
+                                        [&] { return errors::fixed_size_mismatch(N, v.size(), ctx); });
+
+                for (const auto &[key, value]: v) {
+                    is_value = false;
+                    DefaultSerializer<K>::write(w, key, ctx);
+                    is_value = true;
+                    DefaultSerializer<V>::write(w, value, ctx);
+                    ++index;
+                }
+            }
+
+            static void read(io::Reader auto &r, std::unordered_map<K, V> &out, context_like auto &ctx) {
+                size_t index = 0;
+                [[maybe_unused]] bool is_value = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::unordered_map", p_str(), errors::frame_text{is_value ? "Value " : "Key ", index}
+                    };
+                });
+
+                out.clear();
+                for (; index < N; ++index) {
+                    is_value = false;
+                    K key;
+                    DefaultSerializer<K>::read(r, key, ctx);
+                    is_value = true;
+                    V value;
+                    DefaultSerializer<V>::read(r, value, ctx);
+
+                    if (detail::checks(ctx, errors::error_policy::STRICT))
+                        if (out.contains(key))
+                            return detail::fail(ctx, errors::code::duplicate_key, [&] {
+                                return errors::make(errors::code::duplicate_key, ctx,
+                                                    std::string("duplicate key in std::unordered_map"));
+                            });
+
+                    out.emplace(std::move(key), std::move(value));
+                }
+            }
+        };
+
+        // std::set
+        // [Varint length][Elem 0][Elem 1]...
+        template<typename T, typename A> requires types::default_serializable<T>
+        struct Serializer<std::set<T, std::less<T>, A>, proto::Varint> {
+            using set_type = std::set<T, std::less<T>, A>;
+
+            static void write(io::Writer auto &w, const set_type &v, context_like auto &ctx) {
+                size_t index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::set", "Varint", errors::frame_text{"Elem ", index},
+                        errors::frame_text{"length=", v.size()}
+                    };
+                });
+
+                detail::write_varint(w, v.size());
+                for (const auto &elem: v) {
+                    DefaultSerializer<T>::write(w, elem, ctx);
+                    ++index;
+                }
+            }
+
+            static void read(io::Reader auto &r, set_type &out, context_like auto &ctx) {
+                size_t index = 0;
+                size_t size = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::set", "Varint", errors::frame_text{"Elem ", index},
+                        errors::frame_text{"length=", size}
+                    };
+                });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+
+                detail::adopt_resource(out, ctx);
+                out.clear();
+                for (; index < size; ++index) {
+                    T elem = detail::make_element<T>(out);
+                    DefaultSerializer<T>::read(r, elem, ctx);
+                    out.emplace(std::move(elem));
+                }
+            }
+        };
+
+        // std::unordered_set
+        // [Varint length][Elem 0][Elem 1]...
+        template<typename T, typename A> requires types::default_serializable<T>
+        struct Serializer<std::unordered_set<T, std::hash<T>, std::equal_to<T>, A>, proto::Varint> {
+            using set_type = std::unordered_set<T, std::hash<T>, std::equal_to<T>, A>;
+
+            static void write(io::Writer auto &w, const set_type &v, context_like auto &ctx) {
+                size_t index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::unordered_set", "Varint", errors::frame_text{"Elem ", index},
+                        errors::frame_text{"length=", v.size()}
+                    };
+                });
+
+                detail::write_varint(w, v.size());
+                for (const auto &elem: v) {
+                    DefaultSerializer<T>::write(w, elem, ctx);
+                    ++index;
+                }
+            }
+
+            static void read(io::Reader auto &r, set_type &out, context_like auto &ctx) {
+                size_t index = 0;
+                size_t size = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::unordered_set", "Varint", errors::frame_text{"Elem ", index},
+                        errors::frame_text{"length=", size}
+                    };
+                });
+
+                size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(size, ctx); });
+
+                detail::adopt_resource(out, ctx);
+                out.clear();
+                for (; index < size; ++index) {
+                    T elem = detail::make_element<T>(out);
+                    DefaultSerializer<T>::read(r, elem, ctx);
+                    out.emplace(std::move(elem));
+                }
+            }
+        };
+
+        // std::array
+        // [Elem 0][Elem 1]...
+        template<typename T, size_t N> requires types::default_serializable<T>
+        struct Serializer<std::array<T, N>, proto::Fixed<> > {
+            static errors::frame_text t_str() { return {"std::array<", N, ">"}; }
+
+            static void write(io::Writer auto &w, const std::array<T, N> &v, context_like auto &ctx) {
+                size_t index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        t_str(), "Fixed<>", errors::frame_text{"Elem ", index}
+                    };
+                });
+
+                if constexpr (detail::fixed_width<T, proto::Default> && !std::is_same_v<T, bool>) {
+                    detail::write_fixed_array<T, proto::Default>(w, v.data(), N);
+                } else {
+                    for (; index < N; ++index) {
+                        DefaultSerializer<T>::write(w, v[index], ctx);
+                    }
+                }
+            }
+
+            static void read(io::Reader auto &r, std::array<T, N> &out, context_like auto &ctx) {
+                size_t index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        t_str(), "Fixed<>", errors::frame_text{"Elem ", index}
+                    };
+                });
+
+                if constexpr (detail::fixed_width<T, proto::Default> && !std::is_same_v<T, bool>) {
+                    detail::read_fixed_array<T, proto::Default>(r, out.data(), N, ctx);
+                } else {
+                    for (; index < N; ++index) {
+                        DefaultSerializer<T>::read(r, out[index], ctx);
+                    }
                 }
             }
+        };
 
-            static void read(io::Reader auto &r, std::map<K, V> &out, context &ctx) {
-                size_t index = 0;
-                size_t size = 0;
-                [[maybe_unused]] bool is_value = false;
-                auto g = ctx.guard<true, false, false>([&] {
+
+        // --- Serializers for Structured Types --------------------------------
+        // 结构化类型的序列化器
+        // pair
+        // [Field 1][Field 2]
+        template<typename T1, typename T2> requires (types::default_serializable<T1> &&
+                                                     types::default_serializable<T2>)
+        struct Serializer<std::pair<T1, T2>, proto::Fixed<> > {
+            static void write(io::Writer auto &w, const std::pair<T1, T2> &v, context_like auto &ctx) {
+                [[maybe_unused]] bool is_second = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{"std::pair", "Fixed<>", (is_second ? "Second" : "First")};
+                });
+
+                DefaultSerializer<T1>::write(w, v.first, ctx);
+                is_second = true;
+                DefaultSerializer<T2>::write(w, v.second, ctx);
+            }
+
+            static void read(io::Reader auto &r, std::pair<T1, T2> &out, context_like auto &ctx) {
+                [[maybe_unused]] bool is_second = false;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{"std::pair", "Fixed<>", (is_second ? "Second" : "First")};
+                });
+
+                DefaultSerializer<T1>::read(r, out.first, ctx);
+                is_second = true;
+                DefaultSerializer<T2>::read(r, out.second, ctx);
+            }
+        };
+
+        // tuple
+        // [Field 1][Field 2]...
+        template<typename... Ts> requires types::all_serializable<Ts...>
+        struct Serializer<std::tuple<Ts...>, proto::Fixed<> > {
+            static void write(io::Writer auto &w, const std::tuple<Ts...> &v, context_like auto &ctx) {
+                [[maybe_unused]] size_t field_index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
                     return errors::value_frame{
-                        "std::map", "Varint", detail::concat(is_value ? "Value " : "Key ", index),
-                        detail::concat("length=", size)
+                        "std::tuple", "Fixed<>", errors::frame_text{"Field ", field_index}
                     };
                 });
 
-                size = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-                if (ctx.sf.policy <= errors::error_policy::MEDIUM)
-                    if (size > ctx.sf.max_container_size) throw errors::container_too_large(size, ctx);
+                [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    ((DefaultSerializer<std::tuple_element_t<Is, std::tuple<Ts...> > >::write(w, std::get<Is>(v), ctx)),
+                        ...);
+                }(std::make_index_sequence<sizeof...(Ts)>{});
+            }
 
-                out.clear();
-                for (; index < size; index++) {
-                    is_value = false;
-                    K key;
-                    DefaultSerializer<K>::read(r, key, ctx);
-                    is_value = true;
-                    V value;
-                    DefaultSerializer<V>::read(r, value, ctx);
+            static void read(io::Reader auto &r, std::tuple<Ts...> &out, context_like auto &ctx) {
+                [[maybe_unused]] size_t field_index = 0;
+                auto g = ctx.template guard<true, false, false>([&] {
+                    return errors::value_frame{
+                        "std::tuple", "Fixed<>", errors::frame_text{"Field ", field_index}
+                    };
+                });
+
+                [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    ((DefaultSerializer<std::tuple_element_t<Is, std::tuple<Ts...> > >::read(r, std::get<Is>(out), ctx))
+                        , ...);
+                }(std::make_index_sequence<sizeof...(Ts)>{});
+            }
+        };
+
+
+        // --- Serializers for Schemas -----------------------------------------
+        // 模式串序列化器
+        // Compile-Time specified
+        template<typename T, size_t V> requires types::schema_serializable<T>
+        struct Serializer<T, proto::Schema<V> > {
+            static constexpr size_t exact_index = schema::match_schema_index<T, V>();
+            static_assert(exact_index != SIZE_MAX, "bsp: no suitable schema under version V");
+
+            static constexpr const auto &entry = std::get<exact_index>(schema::SchemaSet<T>::schemas);
+
+            static errors::frame_text p_str() {
+                return V == SIZE_MAX ? errors::frame_text{"Schema<MAX>"} : errors::frame_text{"Schema<", V, ">"};
+            }
+
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                detail::write_fields<T, exact_index>(w, v, ctx, schema::SchemaSet<T>::Typename, p_str());
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                detail::read_fields<T, exact_index>(r, out, ctx, schema::SchemaSet<T>::Typename, p_str());
+            }
+        };
+
+        // Runtime dispatch
+        template<typename T> requires types::schema_serializable<T>
+        struct Serializer<T, proto::DynSchema> {
+            static constexpr auto &schemas = schema::SchemaSet<T>::schemas;
+            static constexpr size_t count = schema::SchemaSet<T>::schema_count;
+
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                using W = std::remove_reference_t<decltype(w)>;
+                write_table<W, std::remove_reference_t<decltype(ctx)> >[resolve(ctx)](w, v, ctx);
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                using R = std::remove_reference_t<decltype(r)>;
+                read_table<R, std::remove_reference_t<decltype(ctx)> >[resolve(ctx)](r, out, ctx);
+            }
+
+        private:
+            static size_t resolve(context_like auto &ctx) {
+                const size_t index = schema::match_schema_index<T>(ctx.opt.target_schema_version);
+                if (index == SIZE_MAX) {
+                    detail::fail(ctx, errors::code::invalid_index, [&] {
+                        auto e = errors::make(errors::code::invalid_index, ctx,
+                                              detail::concat("no suitable schema under version",
+                                                             ctx.opt.target_schema_version));
+                        if constexpr (detail::traced<decltype(ctx)>)
+                            ctx.get_traceback().push(errors::value_frame{
+                                schema::SchemaSet<T>::Typename, "DynSchema"
+                            });
+                        return e;
+                    });
+                    return 0;
+                }
+                return index;
+            }
+
+            template<size_t Index, typename W>
+            static void write_entry(W &w, const T &v, context_like auto &ctx) {
+                detail::write_fields<T, Index>(w, v, ctx, schema::SchemaSet<T>::Typename, "DynSchema");
+            }
+
+            template<size_t Index, typename R>
+            static void read_entry(R &r, T &out, context_like auto &ctx) {
+                detail::read_fields<T, Index>(r, out, ctx, schema::SchemaSet<T>::Typename, "DynSchema");
+            }
+
+            // One entry per schema version, indexed by match_schema_index
+            template<typename W, typename C>
+            static constexpr auto write_table = []<size_t... Is>(std::index_sequence<Is...>) {
+                return std::array{&write_entry<Is, W, C>...};
+            }(std::make_index_sequence<count>{});
+
+            template<typename R, typename C>
+            static constexpr auto read_table = []<size_t... Is>(std::index_sequence<Is...>) {
+                return std::array{&read_entry<Is, R, C>...};
+            }(std::make_index_sequence<count>{});
+        };
+
+        // Self-describing
+        // [Varint version]([Varint length] if Sized)[Fields]
+        template<typename T, bool Sized> requires types::schema_serializable<T>
+        struct Serializer<T, proto::Versioned<Sized> > {
+            static constexpr auto &schemas = schema::SchemaSet<T>::schemas;
+            static constexpr size_t count = schema::SchemaSet<T>::schema_count;
+            static constexpr const char *p_str = Sized ? "Versioned<true>" : "Versioned<false>";
+
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                const size_t index = schema::match_schema_index<T>(ctx.opt.target_schema_version);
+                if (index == SIZE_MAX) {
+                    return detail::fail(ctx, errors::code::invalid_index, [&] {
+                        auto e = errors::make(errors::code::invalid_index, ctx,
+                                              detail::concat("no suitable schema under version ",
+                                                             ctx.opt.target_schema_version));
+                        if constexpr (detail::traced<decltype(ctx)>)
+                            ctx.get_traceback().push(errors::value_frame{
+                                schema::SchemaSet<T>::Typename, p_str
+                            });
+                        return e;
+                    });
+                }
+
+                write_table<std::remove_reference_t<decltype(w)>, std::remove_reference_t<decltype(ctx)> >[index](
+                    w, v, ctx);
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                size_t version = SIZE_MAX;
+                auto g = ctx.template guard<false, false, false>([&] {
+                    return errors::wrapper_frame{errors::frame_text{p_str, " version=", version}};
+                });
+
+                version = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                const size_t index = schema::match_schema_index<T>(version);
+                if (index == SIZE_MAX)
+                    return detail::fail(ctx, errors::code::invalid_index, [&] {
+                        return errors::make(errors::code::invalid_index, ctx,
+                                            detail::concat("no suitable schema under version ", version));
+                    });
+
+                read_table<std::remove_reference_t<decltype(r)>, std::remove_reference_t<decltype(ctx)> >[index](
+                    r, out, ctx, version);
+            }
+
+        private:
+            template<size_t Index, typename W>
+            static void write_entry(W &w, const T &v, context_like auto &ctx) {
+                detail::write_varint(w, std::get<Index>(schemas).version);
+
+                auto write_value = [&](auto &out) {
+                    detail::write_fields<T, Index>(out, v, ctx, schema::SchemaSet<T>::Typename, p_str);
+                };
+                if constexpr (Sized)
+                    detail::write_sized(w, write_value);
+                else
+                    write_value(w);
+            }
+
+            template<size_t Index, typename R>
+            static void read_entry(R &r, T &out, context_like auto &ctx, const size_t version) {
+                constexpr size_t known = std::get<Index>(schemas).version;
+
+                if constexpr (Sized) {
+                    const size_t len = detail::read_varint<size_t>(r,
+                                                                   detail::checks(ctx, errors::error_policy::MEDIUM));
+                    io::LimitedReader limited_r(r, len);
+                    detail::read_fields<T, Index>(limited_r, out, ctx, schema::SchemaSet<T>::Typename, p_str);
+
+                    // Trailing bytes belong to fields of a newer version
+                    if (version == known && limited_r.remaining != 0 &&
+                        detail::checks(ctx, errors::error_policy::STRICT))
+                        return detail::fail(ctx, errors::code::fixed_size_mismatch, [&] {
+                            return errors::make(errors::code::fixed_size_mismatch, ctx,
+                                                detail::concat("schema version ", version, " left ",
+                                                               limited_r.remaining, " of ", len, " bytes unread"));
+                        });
+                    limited_r.skip_remaining();
+                } else {
+                    if (version != known)
+                        return detail::fail(ctx, errors::code::invalid_index, [&] {
+                            return errors::make(errors::code::invalid_index, ctx,
+                                                detail::concat("unknown schema version ", version,
+                                                               " cannot be skipped without length"));
+                        });
+                    detail::read_fields<T, Index>(r, out, ctx, schema::SchemaSet<T>::Typename, p_str);
+                }
+            }
+
+            template<typename W, typename C>
+            static constexpr auto write_table = []<size_t... Is>(std::index_sequence<Is...>) {
+                return std::array{&write_entry<Is, W, C>...};
+            }(std::make_index_sequence<count>{});
+
+            template<typename R, typename C>
+            static constexpr auto read_table = []<size_t... Is>(std::index_sequence<Is...>) {
+                return std::array{&read_entry<Is, R, C>...};
+            }(std::make_index_sequence<count>{});
+        };
+
+        // Tagged fields
+        // ([Varint id << 3 | wire type]([Varint length] if length-delimited)[Field])...[Varint 0]
+        template<typename T, size_t V> requires types::schema_serializable<T>
+        struct Serializer<T, proto::Tagged<V> > {
+            static constexpr size_t exact_index = schema::match_schema_index<T, V>();
+            static_assert(exact_index != SIZE_MAX, "bsp: no suitable schema under version V");
+            static_assert(detail::validate_tagged_ids<T, exact_index>(), "bsp: field ids must be unique");
+
+            static constexpr const auto &entry = std::get<exact_index>(schema::SchemaSet<T>::schemas);
+            static constexpr size_t count = std::tuple_size_v<detail::entry_fields_t<T, exact_index> >;
+
+            static errors::frame_text p_str() {
+                return V == SIZE_MAX ? errors::frame_text{"Tagged<MAX>"} : errors::frame_text{"Tagged<", V, ">"};
+            }
+
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                [[maybe_unused]] const char *current_field = nullptr;
+                auto g = ctx.template guard<true, false, false>([&] { return frame(current_field); });
+
+                [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    ((current_field = std::get<Is>(entry.fields).name,
+                      detail::write_tagged_field<T, exact_index, Is>(w, v, ctx)), ...);
+                }(std::make_index_sequence<count>{});
+                current_field = nullptr;
+                w.write_byte(0);
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                [[maybe_unused]] const char *current_field = nullptr;
+                auto g = ctx.template guard<true, false, false>([&] { return frame(current_field); });
+                using R = std::remove_reference_t<decltype(r)>;
+
+                while (true) {
+                    current_field = nullptr;
+                    const size_t tag = detail::read_varint<size_t>(r,
+                                                                   detail::checks(ctx, errors::error_policy::MEDIUM));
+                    if (tag == 0) return;
+
+                    const auto wt = static_cast<detail::wire_type>(tag & 7);
+                    const size_t pos = detail::tagged_field_pos<T, exact_index>(tag >> 3);
+                    if (pos == SIZE_MAX) {
+                        // Unknown fields come from other versions
+                        detail::skip_wire(r, wt, ctx);
+                        continue;
+                    }
+                    current_field = names[pos];
+                    read_table<R, std::remove_reference_t<decltype(ctx)> >[pos](r, out, ctx, wt);
+                }
+            }
+
+        private:
+            static errors::value_frame frame(const char *current_field) {
+                return errors::value_frame{
+                    .type = schema::SchemaSet<T>::Typename,
+                    .proto = p_str(),
+                    .child_label = current_field
+                                       ? errors::frame_text{"Field \"", current_field, "\""}
+                                       : errors::frame_text{},
+                    .details = errors::frame_text{"exact version ", entry.version}
+                };
+            }
+
+            static constexpr auto names = []<size_t... Is>(std::index_sequence<Is...>) {
+                return std::array<const char *, count>{std::get<Is>(entry.fields).name...};
+            }(std::make_index_sequence<count>{});
+
+            template<typename R, typename C>
+            static constexpr auto read_table = []<size_t... Is>(std::index_sequence<Is...>) {
+                return std::array{&detail::read_tagged_field<T, exact_index, Is, R, C>...};
+            }(std::make_index_sequence<count>{});
+        };
+
+        // --- Serializers for Variable Types ----------------------------------
+        // 可变类型的序列化器
+        // std::optional
+        // [0/1 Bool](T if having value)
+        template<typename T> requires types::default_serializable<T>
+        struct Serializer<std::optional<T>, proto::Varint> {
+            static void write(io::Writer auto &w, const std::optional<T> &v, context_like auto &ctx) {
+                const bool has = v.has_value();
+                auto g = ctx.template guard<false, false, false>([] { return errors::wrapper_frame("std::optional"); });
+
+                w.write_byte(static_cast<uint8_t>(has));
+                if (has) {
+                    DefaultSerializer<T>::write(w, v.value(), ctx);
+                }
+            }
+
+            static void read(io::Reader auto &r, std::optional<T> &out, context_like auto &ctx) {
+                bool has = false;
+                auto g = ctx.template guard<false, false, false>([] { return errors::wrapper_frame("std::optional"); });
+
+                const uint8_t has_byte = r.read_byte();
+                if (detail::checks(ctx, errors::error_policy::STRICT) && has_byte > 1)
+                    return detail::fail(ctx, errors::code::invalid_bool,
+                                        [&] { return errors::invalid_bool(has_byte, ctx); });
+                has = static_cast<bool>(has_byte);
+
+                if (has) {
+                    T value{};
+                    DefaultSerializer<T>::read(r, value, ctx);
+                    out = std::move(value);
+                } else {
+                    out = std::nullopt;
+                }
+            }
+        };
+
+        // std::variant
+        // [Varint index][Selected T]
+        template<typename... Ts> requires types::all_serializable<Ts...>
+        struct Serializer<std::variant<Ts...>, proto::Varint> {
+            static void write(io::Writer auto &w, const std::variant<Ts...> &v, context_like auto &ctx) {
+                const size_t which = v.index();
+                auto g = ctx.template guard<false, false, false>([&] {
+                    return errors::wrapper_frame{
+                        errors::frame_text{"std::variant (index=", which, ")"}
+                    };
+                });
+
+                detail::write_varint(w, which);
+
+                std::visit([&](const auto &value) {
+                    using ValueType = std::decay_t<decltype(value)>;
+                    DefaultSerializer<ValueType>::write(w, value, ctx);
+                }, v);
+            }
+
+            static void read(io::Reader auto &r, std::variant<Ts...> &out, context_like auto &ctx) {
+                size_t which = SIZE_MAX;
+
+                auto g = ctx.template guard<false, false, false>([&] {
+                    return errors::wrapper_frame{
+                        errors::frame_text{"std::variant (index=", which, ")"}
+                    };
+                });
+
+                which = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+
+                if (which >= sizeof...(Ts))
+                    return detail::fail(ctx, errors::code::invalid_index, [&] {
+                        return errors::make(errors::code::invalid_index, ctx,
+                                            detail::concat("variant index ", which, " out of range"));
+                    });
+
+                read_table<std::remove_reference_t<decltype(r)>, std::remove_reference_t<decltype(ctx)> >[which](
+                    r, out, ctx);
+            }
+
+        private:
+            template<size_t I, typename R>
+            static void read_alternative(R &r, std::variant<Ts...> &out, context_like auto &ctx) {
+                using A = std::variant_alternative_t<I, std::variant<Ts...> >;
+                A value{};
+                DefaultSerializer<A>::read(r, value, ctx);
+                out.template emplace<I>(std::move(value));
+            }
+
+            // Indexed by the wire index instead of comparing it against every alternative
+            template<typename R, typename C>
+            static constexpr auto read_table = []<size_t... Is>(std::index_sequence<Is...>) {
+                return std::array{&read_alternative<Is, R, C>...};
+            }(std::make_index_sequence<sizeof...(Ts)>{});
+        };
+
+
+        // --- Serializers for Types with Specified Protocol -------------------
+        // 指定协议的类型的序列化器
+        // types::PVal
+        // [T with prototag ProtocolT]
+        template<typename T, typename ProtocolT, typename Protocol>
+            requires (!std::is_base_of_v<proto::WrapperProto, Protocol> &&
+                      types::serializable<T, ProtocolT>)
+        struct Serializer<types::PVal<T, ProtocolT>, Protocol> {
+            static void write(io::Writer auto &w, const types::PVal<T, ProtocolT> &v, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] { return errors::wrapper_frame("PVal"); });
+                Serializer<T, ProtocolT>::write(w, v.value, ctx);
+            }
+
+            static void read(io::Reader auto &r, types::PVal<T, ProtocolT> &v, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] { return errors::wrapper_frame("PVal"); });
+                Serializer<T, ProtocolT>::read(r, v.value, ctx);
+            }
+        };
+
+        // types::CVal
+        // [Unknown in compile-time, defined in CVal]
+        template<typename T> requires std::is_base_of_v<types::CVal, T>
+        struct Serializer<T, proto::Custom> {
+            static void write(io::AnyWriter &w, const T &v, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] { return errors::value_frame("CVal", "CVal"); });
+                detail::runtime_scope runtime(ctx);
+                v.write(w, runtime.get());
+            }
+
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] { return errors::value_frame("CVal", "CVal"); });
+                io::AnyWriter any_w(w);
+                detail::runtime_scope runtime(ctx);
+                v.write(any_w, runtime.get());
+            }
+
+            static void read(io::AnyReader &r, T &out, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] { return errors::value_frame("CVal", "CVal"); });
+                detail::runtime_scope runtime(ctx);
+                out.read(r, runtime.get());
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] { return errors::value_frame("CVal", "CVal"); });
+                io::AnyReader any_r(r);
+                detail::runtime_scope runtime(ctx);
+                out.read(any_r, runtime.get());
+            }
+        };
+
+
+        // --- Serializers for Trivially-Serializable Types --------------------
+        // 平凡可复制类型的序列化器
+        template<typename T> requires types::trivial_serializable<T>
+        struct Serializer<T, proto::Trivial> {
+            static constexpr const char *t_str = detail::type_name_of<T>();
 
-                    if (ctx.sf.policy <= errors::error_policy::STRICT)
-                        if (out.contains(key))
-                            throw errors::make(errors::code::duplicate_key, ctx,
-                                               std::string("duplicate key in std::map"));
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Trivial"); }, [&] {
+                    w.write_bytes(reinterpret_cast<const uint8_t *>(&v), sizeof(T));
+                });
+            }
 
-                    out.emplace(std::move(key), std::move(value));
-                }
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str, "Trivial"); }, [&] {
+                    r.read_bytes(reinterpret_cast<uint8_t *>(&out), sizeof(T));
+                });
             }
         };
 
-        // [Key 1][Value 1][Key 2][Value 2]...
-        template<typename K, typename V, size_t N> requires (types::default_serializable<K> &&
-                                                             types::default_serializable<V>)
-        struct Serializer<std::map<K, V>, proto::Fixed<N> > {
-            static std::string p_str() { return detail::concat("Fixed<", N, ">"); }
-
-            static void write(io::Writer auto &w, const std::map<K, V> &v, context &ctx) {
-                size_t index = 0;
-                bool is_value = false;
-                auto g = ctx.guard<true, false, false>([&] {
+        template<typename T> requires types::trivial_serializable<T>
+        struct Serializer<std::vector<T>, proto::Trivial> {
+            static void write(io::Writer auto &w, const std::vector<T> &v, context_like auto &ctx) {
+                ctx.leaf([&] {
                     return errors::value_frame{
-                        "std::map", p_str(), detail::concat(is_value ? "Value " : "Key ", index)
+                        "std::vector", "Trivial", {},
+                        errors::frame_text{"length=", v.size()}
                     };
+                }, [&] {
+                    detail::write_varint(w, v.size());
+                    detail::write_payload(w, v.data(), v.size() * sizeof(T));
                 });
-                if (v.size() != N) throw errors::fixed_size_mismatch(N, v.size(), ctx);
-
-                for (const auto &[key, value]: v) {
-                    is_value = false;
-                    DefaultSerializer<K>::write(w, key, ctx);
-                    is_value = true;
-                    DefaultSerializer<V>::write(w, value, ctx);
-                    ++index;
-                }
             }
 
-            static void read(io::Reader auto &r, std::map<K, V> &out, context &ctx) {
-                size_t index = 0;
-                [[maybe_unused]] bool is_value = false;
-                auto g = ctx.guard<true, false, false>([&] {
+            static void read(io::Reader auto &r, std::vector<T> &out, context_like auto &ctx) {
+                size_t size = 0;
+                ctx.leaf([&] {
                     return errors::value_frame{
-                        "std::map", p_str(), detail::concat(is_value ? "Value " : "Key ", index)
+                        "std::vector", "Trivial", {},
+                        errors::frame_text{"length=", size}
                     };
+                }, [&] {
+                    size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                    if (detail::limits(ctx))
+                        if (size > ctx.sf.max_container_size)
+                            return detail::fail(ctx, errors::code::container_too_large,
+                                                [&] { return errors::container_too_large(size, ctx); });
+
+                    out.resize(size);
+                    r.read_bytes(reinterpret_cast<uint8_t *>(out.data()), size * sizeof(T));
                 });
-
-                out.clear();
-                for (; index < N; ++index) {
-                    is_value = false;
-                    K key;
-                    DefaultSerializer<K>::read(r, key, ctx);
-                    is_value = true;
-                    V value;
-                    DefaultSerializer<V>::read(r, value, ctx);
-
-                    if (ctx.sf.policy <= errors::error_policy::STRICT)
-                        if (out.contains(key))
-                            throw errors::make(errors::code::duplicate_key, ctx,
-                                               std::string("duplicate key in std::map"));
-
-                    out.emplace(std::move(key), std::move(value));
-                }
             }
         };
 
-        // std::unordered_map
-        // [Varint length][Key 1][Value 1][Key 2][Value 2]...
-        template<typename K, typename V> requires (types::default_serializable<K> &&
-                                                   types::default_serializable<V>)
-        struct Serializer<std::unordered_map<K, V>, proto::Varint> {
-            static void write(io::Writer auto &w, const std::unordered_map<K, V> &v, context &ctx) {
-                size_t index = 0;
-                bool is_value = false;
-                auto g = ctx.guard<true, false, false>([&] {
+        // Bit-compressed with Little-endian style
+        // Has the same behaviour on different platforms.
+        template<>
+        struct Serializer<std::vector<bool>, proto::Trivial> {
+            static void write(io::Writer auto &w, const std::vector<bool> &v, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([&] {
                     return errors::value_frame{
-                        "std::unordered_map", "Varint", detail::concat(is_value ? "Value " : "Key ", index),
-                        detail::concat("length=", v.size())
+                        "std::vector<bool>", "Trivial", {},
+                        errors::frame_text{"bit count=", v.size()}
                     };
                 });
-
                 detail::write_varint(w, v.size());
-                for (const auto &[key, value]: v) {
-                    is_value = false;
-                    DefaultSerializer<K>::write(w, key, ctx);
-                    is_value = true;
-                    DefaultSerializer<V>::write(w, value, ctx);
-                    ++index;
+
+                const size_t byte_count = (v.size() + 7) / 8;
+                for (size_t i = 0; i < byte_count; ++i) {
+                    uint8_t byte = 0;
+                    for (size_t bit = 0; bit < 8 && (i * 8 + bit) < v.size(); ++bit) {
+                        if (v[i * 8 + bit])
+                            byte |= (1u << bit);
+                    }
+                    w.write_byte(byte);
                 }
             }
 
-            static void read(io::Reader auto &r, std::unordered_map<K, V> &out, context &ctx) {
-                size_t index = 0;
-                size_t size = 0;
-                [[maybe_unused]] bool is_value = false;
-                auto g = ctx.guard<true, false, false>([&] {
+            static void read(io::Reader auto &r, std::vector<bool> &out, context_like auto &ctx) {
+                size_t bit_size = 0;
+                auto g = ctx.template guard<false, false, false>([&] {
                     return errors::value_frame{
-                        "std::unordered_map", "Varint", detail::concat(is_value ? "Value " : "Key ", index),
-                        detail::concat("length=", size)
+                        "std::vector<bool>", "Trivial", {},
+                        errors::frame_text{"bit count=", bit_size}
                     };
                 });
+                bit_size = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (detail::limits(ctx))
+                    if (bit_size > ctx.sf.max_container_size)
+                        return detail::fail(ctx, errors::code::container_too_large,
+                                            [&] { return errors::container_too_large(bit_size, ctx); });
 
-                size = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-                if (ctx.sf.policy <= errors::error_policy::MEDIUM)
-                    if (size > ctx.sf.max_container_size) throw errors::container_too_large(size, ctx);
-
-                out.clear();
-                for (; index < size; ++index) {
-                    is_value = false;
-                    K key;
-                    DefaultSerializer<K>::read(r, key, ctx);
-                    is_value = true;
-                    V value;
-                    DefaultSerializer<V>::read(r, value, ctx);
-
-                    if (ctx.sf.policy <= errors::error_policy::STRICT)
-                        if (out.contains(key))
-                            throw errors::make(errors::code::duplicate_key, ctx,
-                                               std::string("duplicate key in std::unordered_map"));
-
-                    out.emplace(std::move(key), std::move(value));
+                out.resize(bit_size);
+                const size_t byte_count = (bit_size + 7) / 8;
+                for (size_t i = 0; i < byte_count; ++i) {
+                    const uint8_t byte = r.read_byte();
+                    for (size_t bit = 0; bit < 8 && (i * 8 + bit) < bit_size; ++bit) {
+                        out[i * 8 + bit] = (byte & (1u << bit)) != 0;
+                    }
                 }
             }
         };
 
-        // [Key 1][Value 1][Key 2][Value 2]...
-        template<typename K, typename V, size_t N> requires (types::default_serializable<K> &&
-                                                             types::default_serializable<V>)
-        struct Serializer<std::unordered_map<K, V>, proto::Fixed<N> > {
-            static std::string p_str() { return detail::concat("Fixed<", N, ">"); }
+        template<typename T, size_t N> requires types::trivial_serializable<T>
+        struct Serializer<std::array<T, N>, proto::Trivial> {
+            static errors::frame_text t_str() {
+                return {"std::array<", N, ">"};
+            }
 
-            static void write(io::Writer auto &w, const std::unordered_map<K, V> &v, context &ctx) {
-                size_t index = 0;
-                bool is_value = false;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::unordered_map", p_str(), detail::concat(is_value ? "Value " : "Key ", index)
-                    };
+            static void write(io::Writer auto &w, const std::array<T, N> &v, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str(), "Trivial"); }, [&] {
+                    detail::write_payload(w, v.data(), N * sizeof(T));
                 });
-                if (v.size() != N) throw errors::fixed_size_mismatch(N, v.size(), ctx);
-
-                for (const auto &[key, value]: v) {
-                    is_value = false;
-                    DefaultSerializer<K>::write(w, key, ctx);
-                    is_value = true;
-                    DefaultSerializer<V>::write(w, value, ctx);
-                    ++index;
-                }
             }
 
-            static void read(io::Reader auto &r, std::unordered_map<K, V> &out, context &ctx) {
-                size_t index = 0;
-                [[maybe_unused]] bool is_value = false;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::unordered_map", p_str(), detail::concat(is_value ? "Value " : "Key ", index)
-                    };
+            static void read(io::Reader auto &r, std::array<T, N> &out, context_like auto &ctx) {
+                ctx.leaf([] { return errors::value_frame(t_str(), "Trivial"); }, [&] {
+                    r.read_bytes(reinterpret_cast<uint8_t *>(out.data()), N * sizeof(T));
                 });
-
-                out.clear();
-                for (; index < N; ++index) {
-                    is_value = false;
-                    K key;
-                    DefaultSerializer<K>::read(r, key, ctx);
-                    is_value = true;
-                    V value;
-                    DefaultSerializer<V>::read(r, value, ctx);
-
-                    if (ctx.sf.policy <= errors::error_policy::STRICT)
-                        if (out.contains(key))
-                            throw errors::make(errors::code::duplicate_key, ctx,
-                                               std::string("duplicate key in std::unordered_map"));
-
-                    out.emplace(std::move(key), std::move(value));
-                }
             }
         };
 
-        // std::set
-        // [Varint length][Elem 0][Elem 1]...
+
+        // --- Serializers for Pointers ----------------------------------------
+        // 指针的序列化器
         template<typename T> requires types::default_serializable<T>
-        struct Serializer<std::set<T>, proto::Varint> {
-            static void write(io::Writer auto &w, const std::set<T> &v, context &ctx) {
-                size_t index = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::set", "Varint", detail::concat("Elem ", index),
-                        detail::concat("length=", v.size())
-                    };
-                });
+        struct Serializer<T *, proto::Varint> {
+            static void write(io::Writer auto &w, const T *const &v, context_like auto &ctx) {
+                auto g = ctx.template guard<true, false, false>([] { return errors::wrapper_frame("ptr"); });
 
-                detail::write_varint(w, v.size());
-                for (const auto &elem: v) {
-                    DefaultSerializer<T>::write(w, elem, ctx);
-                    ++index;
+                const bool non_null = v != nullptr;
+                w.write_byte(static_cast<uint8_t>(non_null));
+
+                // Errors reported as codes do not unwind, a pointer cycle past max_depth ends here
+                if (non_null && !detail::failed(ctx)) {
+                    DefaultSerializer<T>::write(w, *v, ctx);
                 }
             }
 
-            static void read(io::Reader auto &r, std::set<T> &out, context &ctx) {
-                size_t index = 0;
-                size_t size = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::set", "Varint", detail::concat("Elem ", index),
-                        detail::concat("length=", size)
-                    };
-                });
+            static void read(io::Reader auto &r, T *&out, context_like auto &ctx) {
+                auto g = ctx.template guard<true, false, false>([] { return errors::wrapper_frame("ptr"); });
 
-                size = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-                if (ctx.sf.policy <= errors::error_policy::MEDIUM)
-                    if (size > ctx.sf.max_container_size) throw errors::container_too_large(size, ctx);
+                const uint8_t non_null_byte = r.read_byte();
+                if (detail::checks(ctx, errors::error_policy::STRICT) && non_null_byte > 1)
+                    return detail::fail(ctx, errors::code::invalid_bool,
+                                        [&] { return errors::invalid_bool(non_null_byte, ctx); });
+                const bool non_null = static_cast<bool>(non_null_byte);
 
-                out.clear();
-                for (; index < size; ++index) {
-                    T elem;
-                    DefaultSerializer<T>::read(r, elem, ctx);
-                    out.emplace(std::move(elem));
+                delete out;
+                if (non_null) {
+                    out = new T{};
+                    DefaultSerializer<T>::read(r, *out, ctx);
+                } else {
+                    out = nullptr;
                 }
             }
         };
 
-        // std::unordered_set
-        // [Varint length][Elem 0][Elem 1]...
         template<typename T> requires types::default_serializable<T>
-        struct Serializer<std::unordered_set<T>, proto::Varint> {
-            static void write(io::Writer auto &w, const std::unordered_set<T> &v, context &ctx) {
-                size_t index = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::unordered_set", "Varint", detail::concat("Elem ", index),
-                        detail::concat("length=", v.size())
-                    };
+        struct Serializer<std::unique_ptr<T>, proto::Varint> {
+            static void write(io::Writer auto &w, const std::unique_ptr<T> &v, context_like auto &ctx) {
+                auto g = ctx.template guard<true, false, false>([] {
+                    return errors::wrapper_frame("std::unique_ptr");
                 });
 
-                detail::write_varint(w, v.size());
-                for (const auto &elem: v) {
-                    DefaultSerializer<T>::write(w, elem, ctx);
-                    ++index;
+                const bool non_null = v != nullptr;
+                w.write_byte(static_cast<uint8_t>(non_null));
+
+                if (non_null) {
+                    DefaultSerializer<T>::write(w, *v, ctx);
                 }
             }
 
-            static void read(io::Reader auto &r, std::unordered_set<T> &out, context &ctx) {
-                size_t index = 0;
-                size_t size = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::unordered_set", "Varint", detail::concat("Elem ", index),
-                        detail::concat("length=", size)
-                    };
+            static void read(io::Reader auto &r, std::unique_ptr<T> &out, context_like auto &ctx) {
+                auto g = ctx.template guard<true, false, false>([] {
+                    return errors::wrapper_frame("std::unique_ptr");
                 });
 
-                size = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-                if (ctx.sf.policy <= errors::error_policy::MEDIUM)
-                    if (size > ctx.sf.max_container_size) throw errors::container_too_large(size, ctx);
+                const uint8_t non_null_byte = r.read_byte();
+                if (detail::checks(ctx, errors::error_policy::STRICT) && non_null_byte > 1)
+                    return detail::fail(ctx, errors::code::invalid_bool,
+                                        [&] { return errors::invalid_bool(non_null_byte, ctx); });
+                const bool non_null = static_cast<bool>(non_null_byte);
 
-                out.clear();
-                for (; index < size; ++index) {
-                    T elem;
-                    DefaultSerializer<T>::read(r, elem, ctx);
-                    out.emplace(std::move(elem));
+                if (non_null) {
+                    out = std::make_unique<T>();
+                    DefaultSerializer<T>::read(r, *out, ctx);
+                } else {
+                    out.reset();
                 }
             }
         };
 
-        // std::array
-        // [Elem 0][Elem 1]...
-        template<typename T, size_t N> requires types::default_serializable<T>
-        struct Serializer<std::array<T, N>, proto::Fixed<> > {
-            static std::string t_str() { return detail::concat("std::array<", N, ">"); }
 
-            static void write(io::Writer auto &w, const std::array<T, N> &v, context &ctx) {
-                size_t index = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        t_str(), "Fixed<>", detail::concat("Elem ", index)
-                    };
+        // ~~~ Serializers for Protocols ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+        // 为特定协议设计的序列化器
+
+        // --- Default Fallback ------------------------------------------------
+        // 默认协议映射
+        template<typename T> requires (!std::is_same_v<T, proto::Default> && types::default_serializable<T>)
+        struct Serializer<T, proto::Default> {
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                DefaultSerializer<T>::write(w, v, ctx);
+            }
+
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                DefaultSerializer<T>::read(r, out, ctx);
+            }
+        };
+
+        // --- Serializers for Length-Limited Protocols ------------------------
+        // 限定长度的协议的序列化器
+
+        // proto::Limited
+
+        // [Varint length][Inner payload]
+        template<typename T, typename Inner> requires types::serializable<T, Inner>
+        struct Serializer<T, proto::Limited<proto::Varint, Inner> > {
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] {
+                    return errors::wrapper_frame("Limited<Varint>");
                 });
 
-                for (; index < N; ++index) {
-                    DefaultSerializer<T>::write(w, v[index], ctx);
-                }
+                // Write to temporary buffer to know the size
+                io::BufferWriter tmp;
+                Serializer<T, Inner>::write(tmp, v, ctx);
+
+                detail::write_varint(w, tmp.buf.size());
+                w.write_bytes(tmp.buf.data(), tmp.buf.size());
             }
 
-            static void read(io::Reader auto &r, std::array<T, N> &out, context &ctx) {
-                size_t index = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        t_str(), "Fixed<>", detail::concat("Elem ", index)
-                    };
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                size_t len = 0;
+                auto g = ctx.template guard<false, false, false>([&] {
+                    return errors::wrapper_frame{errors::frame_text{"Limited<Varint> size=", len}};
                 });
 
-                for (; index < N; ++index) {
-                    DefaultSerializer<T>::read(r, out[index], ctx);
-                }
+                len = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                io::LimitedReader limited_r(r, len);
+                Serializer<T, Inner>::read(limited_r, out, ctx);
             }
         };
 
+        // [Inner payload]
+        template<typename T, size_t N, typename Inner> requires types::serializable<T, Inner>
+        struct Serializer<T, proto::Limited<proto::Fixed<N>, Inner> > {
+            static errors::frame_text p_str() { return {"Limited<Fixed<", N, ">>"}; }
 
-        // --- Serializers for Structured Types --------------------------------
-        // 结构化类型的序列化器
-        // pair
-        // [Field 1][Field 2]
-        template<typename T1, typename T2> requires (types::default_serializable<T1> &&
-                                                     types::default_serializable<T2>)
-        struct Serializer<std::pair<T1, T2>, proto::Fixed<> > {
-            static void write(io::Writer auto &w, const std::pair<T1, T2> &v, context &ctx) {
-                [[maybe_unused]] bool is_second = false;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{"std::pair", "Fixed<>", (is_second ? "Second" : "First")};
-                });
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] { return errors::wrapper_frame(p_str()); });
 
-                DefaultSerializer<T1>::write(w, v.first, ctx);
-                is_second = true;
-                DefaultSerializer<T2>::write(w, v.second, ctx);
+                io::BufferWriter tmp;
+                Serializer<T, Inner>::write(tmp, v, ctx);
+
+                if (tmp.buf.size() > N)
+                    return detail::fail(ctx, errors::code::fixed_size_mismatch,
+                                        [&] { return errors::fixed_size_mismatch(N, tmp.buf.size(), ctx); });
+
+                w.write_bytes(tmp.buf.data(), tmp.buf.size());
             }
 
-            static void read(io::Reader auto &r, std::pair<T1, T2> &out, context &ctx) {
-                [[maybe_unused]] bool is_second = false;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{"std::pair", "Fixed<>", (is_second ? "Second" : "First")};
-                });
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] { return errors::wrapper_frame(p_str()); });
 
-                DefaultSerializer<T1>::read(r, out.first, ctx);
-                is_second = true;
-                DefaultSerializer<T2>::read(r, out.second, ctx);
+                const size_t len = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+                if (len > N)
+                    return detail::fail(ctx, errors::code::fixed_size_mismatch,
+                                        [&] { return errors::fixed_size_mismatch(N, len, ctx); });
+
+                io::LimitedReader limited_r(r, len);
+                Serializer<T, Inner>::read(limited_r, out, ctx);
             }
         };
 
-        // tuple
-        // [Field 1][Field 2]...
-        template<typename... Ts> requires types::all_serializable<Ts...>
-        struct Serializer<std::tuple<Ts...>, proto::Fixed<> > {
-            static void write(io::Writer auto &w, const std::tuple<Ts...> &v, context &ctx) {
-                [[maybe_unused]] size_t field_index = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::tuple", "Fixed<>", detail::concat("Field ", field_index)
-                    };
+        // proto::Forced
+
+        // [Varint length][Inner payload padded with zero]
+        template<typename T, typename Inner> requires types::serializable<T, Inner>
+        struct Serializer<T, proto::Forced<proto::Varint, Inner> > {
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] {
+                    return errors::wrapper_frame("Forced<Varint>");
                 });
 
-                [&]<size_t... Is>(std::index_sequence<Is...>) {
-                    ((DefaultSerializer<std::tuple_element_t<Is, std::tuple<Ts...> > >::write(w, std::get<Is>(v), ctx)),
-                        ...);
-                }(std::make_index_sequence<sizeof...(Ts)>{});
+                // Write to temp buffer, then declare the length
+                io::BufferWriter tmp;
+                Serializer<T, Inner>::write(tmp, v, ctx);
+
+                detail::write_varint(w, tmp.buf.size());
+                w.write_bytes(tmp.buf.data(), tmp.buf.size());
             }
 
-            static void read(io::Reader auto &r, std::tuple<Ts...> &out, context &ctx) {
-                [[maybe_unused]] size_t field_index = 0;
-                auto g = ctx.guard<true, false, false>([&] {
-                    return errors::value_frame{
-                        "std::tuple", "Fixed<>", detail::concat("Field ", field_index)
-                    };
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                size_t len = 0;
+                io::LimitedReader limited_r(r, 0);
+                auto g = ctx.template guard<false, false, false>([&] {
+                    limited_r.skip_remaining();
+                    return errors::wrapper_frame{errors::frame_text{"Limited<Varint> size=", len}};
                 });
 
-                [&]<size_t... Is>(std::index_sequence<Is...>) {
-                    ((DefaultSerializer<std::tuple_element_t<Is, std::tuple<Ts...> > >::read(r, std::get<Is>(out), ctx))
-                        , ...);
-                }(std::make_index_sequence<sizeof...(Ts)>{});
+                len = detail::read_varint<size_t>(r, detail::checks(ctx, errors::error_policy::MEDIUM));
+
+                limited_r.remaining = len;
+                Serializer<T, Inner>::read(limited_r, out, ctx);
+                limited_r.skip_remaining();
             }
         };
 
+        // [Inner payload padded with zero]
+        template<typename T, size_t N, typename Inner> requires types::serializable<T, Inner>
+        struct Serializer<T, proto::Forced<proto::Fixed<N>, Inner> > {
+            static errors::frame_text p_str() { return {"Forced<Fixed<", N, ">>"}; }
 
-        // --- Serializers for Schemas -----------------------------------------
-        // 模式串序列化器
-        // Compile-Time specified
-        template<typename T, size_t V> requires types::schema_serializable<T>
-        struct Serializer<T, proto::Schema<V> > {
-            static constexpr size_t exact_index = schema::match_schema_index<T, V>();
-            static_assert(exact_index != SIZE_MAX, "bsp: no suitable schema under version V");
-
-            static constexpr const auto &entry = std::get<exact_index>(schema::SchemaSet<T>::schemas);
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                auto g = ctx.template guard<false, false, false>([] { return errors::wrapper_frame(p_str()); });
 
-            static std::string p_str() {
-                return detail::concat("Schema<", V == SIZE_MAX ? std::string("MAX") : std::to_string(V), ">");
+                io::LimitedWriter limited_w(w, N);
+                Serializer<T, Inner>::write(limited_w, v, ctx);
+                limited_w.pad_zero();
             }
 
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                detail::write_fields<T>(w, v, ctx, entry,
-                                        schema::SchemaSet<T>::Typename, p_str());
-            }
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                io::LimitedReader limited_r(r, N);
+                auto g = ctx.template guard<false, false, false>([&] {
+                    limited_r.skip_remaining();
+                    return errors::wrapper_frame(p_str());
+                });
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                detail::read_fields<T>(r, out, ctx, entry,
-                                       schema::SchemaSet<T>::Typename, p_str());
+                Serializer<T, Inner>::read(limited_r, out, ctx);
+                limited_r.skip_remaining();
             }
         };
 
-        // Runtime dispatch
-        template<typename T> requires types::schema_serializable<T>
-        struct Serializer<T, proto::DynSchema> {
-            static constexpr auto &schemas = schema::SchemaSet<T>::schemas;
-            static constexpr size_t count = schema::SchemaSet<T>::schema_count;
-
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                const bool flag = [&]<size_t... Is>(std::index_sequence<Is...>) {
-                    return (
-                        (std::get<count - 1 - Is>(schemas).version <= ctx.opt.target_schema_version
-                             ? (detail::write_fields<T>(w, v, ctx, std::get<count - 1 - Is>(schemas),
-                                                        schema::SchemaSet<T>::Typename, "DynSchema"),
-                                true)
-                             : false
-                        ) || ...
-                    );
-                }(std::make_index_sequence<count>{});
 
-                if (!flag) {
-                    ctx.get_traceback().frames.emplace_back(errors::value_frame{
-                        schema::SchemaSet<T>::Typename, "DynSchema"
-                    });
-                    throw errors::make(errors::code::invalid_index, ctx,
-                                       detail::concat("no suitable schema under version",
-                                                      ctx.opt.target_schema_version));
-                }
-            }
-
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                const bool flag = [&]<size_t... Is>(std::index_sequence<Is...>) {
-                    return (
-                        (std::get<count - 1 - Is>(schemas).version <= ctx.opt.target_schema_version
-                             ? (detail::read_fields<T>(r, out, ctx, std::get<count - 1 - Is>(schemas),
-                                                       schema::SchemaSet<T>::Typename, "DynSchema"),
-                                true)
-                             : false
-                        ) || ...
-                    );
-                }(std::make_index_sequence<count>{});
+        // ~~~ Syntactic Sugar: Registered Inside Type ~~~~~~~~~~~~~~~~~~~~~~~~~
+        // 语法糖：类内注册
+        template<typename T, typename P> requires types::internal_serializable<T, P>
+        struct Serializer<T, P> {
+            // Members taking context & get one lent by other policies
+            static void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+                if constexpr (requires { T::write(w, v, ctx, P{}); }) {
+                    T::write(w, v, ctx, P{});
+                } else {
+                    detail::runtime_scope runtime(ctx);
+                    T::write(w, v, runtime.get(), P{});
+                }
+            }
 
-                if (!flag) {
-                    ctx.get_traceback().frames.emplace_back(errors::value_frame{
-                        schema::SchemaSet<T>::Typename, "DynSchema"
-                    });
-                    throw errors::make(errors::code::invalid_index, ctx,
-                                       detail::concat("no suitable schema under version",
-                                                      ctx.opt.target_schema_version));
+            static void read(io::Reader auto &r, T &out, context_like auto &ctx) {
+                if constexpr (requires { T::read(r, out, ctx, P{}); }) {
+                    T::read(r, out, ctx, P{});
+                } else {
+                    detail::runtime_scope runtime(ctx);
+                    T::read(r, out, runtime.get(), P{});
                 }
             }
         };
+    }
 
-        // --- Serializers for Variable Types ----------------------------------
-        // 可变类型的序列化器
-        // std::optional
-        // [0/1 Bool](T if having value)
-        template<typename T> requires types::default_serializable<T>
-        struct Serializer<std::optional<T>, proto::Varint> {
-            static void write(io::Writer auto &w, const std::optional<T> &v, context &ctx) {
-                const bool has = v.has_value();
-                auto g = ctx.guard<false, false, false>([] { return errors::wrapper_frame("std::optional"); });
 
-                w.write_byte(static_cast<uint8_t>(has));
-                if (has) {
-                    DefaultSerializer<T>::write(w, v.value(), ctx);
-                }
-            }
+    // === Lazy Views ==========================================================
+    // 惰性视图
+    template<typename T, size_t Version>
+    class lazy {
+        static_assert(types::schema_serializable<T>, "bsp: lazy views need a schema type");
+        static constexpr size_t index = schema::match_schema_index<T, Version>();
+        static_assert(index != SIZE_MAX, "bsp: no suitable schema under version Version");
 
-            static void read(io::Reader auto &r, std::optional<T> &out, context &ctx) {
-                bool has = false;
-                auto g = ctx.guard<false, false, false>([] { return errors::wrapper_frame("std::optional"); });
+        static constexpr const auto &fields = std::get<index>(schema::SchemaSet<T>::schemas).fields;
+        using Fields = detail::entry_fields_t<T, index>;
+        static constexpr size_t count = std::tuple_size_v<Fields>;
 
-                const uint8_t has_byte = r.read_byte();
-                if (ctx.sf.policy <= errors::error_policy::STRICT && has_byte > 1)
-                    throw errors::invalid_bool(has_byte, ctx);
-                has = static_cast<bool>(has_byte);
+    public:
+        lazy(const uint8_t *data, const size_t size, context ctx = context::get_default_context())
+            : data_(data), size_(size), ctx_(std::move(ctx)) {
+        }
 
-                if (has) {
-                    T value{};
-                    DefaultSerializer<T>::read(r, value, ctx);
-                    out = std::move(value);
-                } else {
-                    out = std::nullopt;
-                }
+        explicit lazy(const std::vector<uint8_t> &buf, context ctx = context::get_default_context())
+            : lazy(buf.data(), buf.size(), std::move(ctx)) {
+        }
+
+        // Decodes the field on first access
+        template<auto Member>
+        [[nodiscard]] const auto &get() const {
+            constexpr size_t I = detail::member_index<T, index, Member>();
+            if (!decoded_[I]) decode_field<I>(*this);
+            return value_.*Member;
+        }
+
+        // Encoded bytes of a field, e.g. for forwarding it without decoding
+        template<auto Member>
+        [[nodiscard]] std::span<const uint8_t> raw() const {
+            constexpr size_t I = detail::member_index<T, index, Member>();
+            locate(I + 1);
+            return {data_ + offsets_[I], offsets_[I + 1] - offsets_[I]};
+        }
+
+        // Encoded bytes of the whole message
+        [[nodiscard]] std::span<const uint8_t> bytes() const {
+            locate(count);
+            return {data_, offsets_[count]};
+        }
+
+        [[nodiscard]] T materialize() const {
+            for (size_t i = 0; i < count; ++i)
+                if (!decoded_[i]) decode_table[i](*this);
+            return value_;
+        }
+
+    private:
+        const uint8_t *data_;
+        size_t size_;
+        mutable context ctx_;
+
+        // offsets_[0, located_] are known, offsets_[i + 1] is the end of field i
+        mutable std::array<size_t, count + 1> offsets_{};
+        mutable size_t located_ = 0;
+        mutable std::array<bool, count> decoded_{};
+        mutable T value_{};
+
+        auto guard(const size_t i) const {
+            return ctx_.template guard<true, false, false>([this, i] {
+                return errors::value_frame{
+                    .type = schema::SchemaSet<T>::Typename,
+                    .proto = "lazy",
+                    .child_label = errors::frame_text{"Field \"", names[i], "\""},
+                    .details = errors::frame_text{"offset ", offsets_[i]}
+                };
+            });
+        }
+
+        // Skips the fields before i that were never reached
+        void locate(const size_t i) const {
+            while (located_ < i) {
+                auto g = guard(located_);
+                offsets_[located_ + 1] = offsets_[located_] + skip_table[located_](
+                                             data_ + offsets_[located_], size_ - offsets_[located_], ctx_);
+                ++located_;
             }
-        };
+        }
 
-        // std::variant
-        // [Varint index][Selected T]
-        template<typename... Ts> requires types::all_serializable<Ts...>
-        struct Serializer<std::variant<Ts...>, proto::Varint> {
-            static void write(io::Writer auto &w, const std::variant<Ts...> &v, context &ctx) {
-                const size_t which = v.index();
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::wrapper_frame{
-                        detail::concat("std::variant (index=", which, ")")
-                    };
-                });
+        template<size_t I>
+        static size_t skip_field(const uint8_t *p, const size_t n, context &ctx) {
+            using F = std::tuple_element_t<I, Fields>;
+            io::BytesReader r(p, n);
+            detail::skip_value<typename F::field_type, typename F::protocol>(r, ctx);
+            return r.pos;
+        }
 
-                detail::write_varint(w, which);
+        template<size_t I>
+        static void decode_field(const lazy &self) {
+            using F = std::tuple_element_t<I, Fields>;
+            self.locate(I);
+            auto g = self.guard(I);
 
-                std::visit([&](const auto &value) {
-                    using ValueType = std::decay_t<decltype(value)>;
-                    DefaultSerializer<ValueType>::write(w, value, ctx);
-                }, v);
+            io::BytesReader r(self.data_ + self.offsets_[I], self.size_ - self.offsets_[I]);
+            serialize::Serializer<typename F::field_type, typename F::protocol>::read(
+                r, self.value_.*(std::get<I>(fields).ptr), self.ctx_);
+            self.decoded_[I] = true;
+            if (self.located_ == I) {
+                self.offsets_[I + 1] = self.offsets_[I] + r.pos;
+                self.located_ = I + 1;
             }
+        }
 
-            static void read(io::Reader auto &r, std::variant<Ts...> &out, context &ctx) {
-                size_t which = SIZE_MAX;
+        static constexpr auto names = []<size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<const char *, count>{std::get<Is>(fields).name...};
+        }(std::make_index_sequence<count>{});
 
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::wrapper_frame{
-                        detail::concat("std::variant (index=", which, ")")
-                    };
-                });
+        static constexpr auto skip_table = []<size_t... Is>(std::index_sequence<Is...>) {
+            return std::array{&skip_field<Is>...};
+        }(std::make_index_sequence<count>{});
 
-                which = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
+        static constexpr auto decode_table = []<size_t... Is>(std::index_sequence<Is...>) {
+            return std::array{&decode_field<Is>...};
+        }(std::make_index_sequence<count>{});
+    };
 
-                if (which >= sizeof...(Ts))
-                    throw errors::make(errors::code::invalid_index, ctx,
-                                       detail::concat("variant index ", which, " out of range"));
 
-                [&]<size_t... Is>(std::index_sequence<Is...>) {
-                    return (
-                        (
-                            which == Is
-                                ? [&] {
-                                    std::decay_t<decltype(std::get<Is>(std::declval<std::variant<Ts...> >()))> value{};
-                                    DefaultSerializer<
-                                        std::decay_t<decltype(std::get<Is>(std::declval<std::variant<Ts...> >()))>
-                                    >::read(r, value, ctx);
-                                    out.template emplace<Is>(std::move(value));
-                                }()
-                                : void()
-                        ),
-                        ...
-                    );
-                }(std::make_index_sequence<sizeof...(Ts)>{});
-            }
-        };
+    template<typename T, typename Inner>
+    class indexed_view {
+        static_assert(types::serializable<T, Inner>, "bsp: element type is not serializable with Inner");
 
+    public:
+        // data points to a std::vector<T> written with Indexed<Inner>
+        indexed_view(const uint8_t *data, const size_t size, context ctx = context::get_default_context())
+            : ctx_(std::move(ctx)) {
+            io::BytesReader r(data, size);
+            count_ = detail::read_varint<size_t>(r, true);
+            payload_size_ = detail::read_varint<size_t>(r, true);
+            width_ = std::bit_width(payload_size_);
+            if (width_ > detail::max_packed_width)
+                BSP_THROW(errors::make(errors::code::container_too_large, ctx_,
+                                       detail::concat("indexed payload of ", payload_size_, " bytes is too large")));
+
+            // Bounds are checked before computing the table size, so it cannot overflow
+            const size_t rest = size - r.pos;
+            if (count_ > 1 && count_ - 1 > rest * 8 / std::max(width_, 1u))
+                BSP_THROW(errors::unexpected_eof(count_ - 1, rest * 8 / std::max(width_, 1u), "indexed_view"));
+            table_ = r.borrow_bytes(count_ == 0 ? 0 : detail::packed_bytes(count_ - 1, width_));
+            payload_ = r.borrow_bytes(payload_size_);
+            encoded_size_ = r.pos;
+        }
 
-        // --- Serializers for Types with Specified Protocol -------------------
-        // 指定协议的类型的序列化器
-        // types::PVal
-        // [T with prototag ProtocolT]
-        template<typename T, typename ProtocolT, typename Protocol>
-            requires (!std::is_base_of_v<proto::WrapperProto, Protocol> &&
-                      types::serializable<T, ProtocolT>)
-        struct Serializer<types::PVal<T, ProtocolT>, Protocol> {
-            static void write(io::Writer auto &w, const types::PVal<T, ProtocolT> &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::wrapper_frame("PVal"); });
-                Serializer<T, ProtocolT>::write(w, v.value, ctx);
-            }
+        explicit indexed_view(const std::vector<uint8_t> &buf, context ctx = context::get_default_context())
+            : indexed_view(buf.data(), buf.size(), std::move(ctx)) {
+        }
 
-            static void read(io::Reader auto &r, types::PVal<T, ProtocolT> &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::wrapper_frame("PVal"); });
-                Serializer<T, ProtocolT>::read(r, v.value, ctx);
-            }
-        };
+        [[nodiscard]] size_t size() const { return count_; }
 
-        // types::CVal
-        // [Unknown in compile-time, defined in CVal]
-        template<typename T> requires std::is_base_of_v<types::CVal, T>
-        struct Serializer<T, proto::Custom> {
-            static void write(io::AnyWriter &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("CVal", "CVal"); });
-                v.write(w, ctx);
-            }
+        // Bytes of the whole encoded vector
+        [[nodiscard]] size_t encoded_size() const { return encoded_size_; }
 
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("CVal", "CVal"); });
-                io::AnyWriter any_w(w);
-                v.write(any_w, ctx);
-            }
+        [[nodiscard]] std::span<const uint8_t> raw(const size_t i) const {
+            check_index(i);
+            const size_t begin = begin_of(i), end = begin_of(i + 1);
+            if (begin > end || end > payload_size_)
+                BSP_THROW(errors::make(errors::code::fixed_size_mismatch, ctx_,
+                                       detail::concat("corrupt offset table at element ", i)));
+            return {payload_ + begin, end - begin};
+        }
 
-            static void read(io::AnyReader &r, T &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("CVal", "CVal"); });
-                out.read(r, ctx);
-            }
+        // Decodes element i only
+        [[nodiscard]] T at(const size_t i) const {
+            const auto bytes = raw(i);
+            T out{};
+            auto g = guard(i);
+            io::BytesReader r(bytes.data(), bytes.size());
+            serialize::Serializer<T, Inner>::read(r, out, ctx_);
+            if (r.pos != bytes.size() && detail::checks(ctx_, errors::error_policy::STRICT))
+                BSP_THROW(errors::make(errors::code::fixed_size_mismatch, ctx_,
+                                       detail::concat("element ", i, " left ", bytes.size() - r.pos, " bytes unread")));
+            return out;
+        }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame("CVal", "CVal"); });
-                io::AnyReader any_r(r);
-                out.read(any_r, ctx);
-            }
-        };
+        // Decodes elements [first, last)
+        [[nodiscard]] std::vector<T> range(const size_t first, const size_t last) const {
+            if (first > last || last > count_)
+                BSP_THROW(errors::make(errors::code::invalid_index, ctx_,
+                                       detail::concat("range [", first, ", ", last, ") out of ", count_, " elements")));
+            std::vector<T> out;
+            out.reserve(last - first);
+            for (size_t i = first; i < last; ++i)
+                out.push_back(at(i));
+            return out;
+        }
 
+    private:
+        const uint8_t *table_ = nullptr;
+        const uint8_t *payload_ = nullptr;
+        size_t count_ = 0;
+        size_t payload_size_ = 0;
+        size_t encoded_size_ = 0;
+        unsigned width_ = 0;
+        mutable context ctx_;
+
+        [[nodiscard]] size_t begin_of(const size_t i) const {
+            if (i == 0) return 0;
+            if (i == count_) return payload_size_;
+            return detail::load_packed(table_, i - 1, width_);
+        }
 
-        // --- Serializers for Trivially-Serializable Types --------------------
-        // 平凡可复制类型的序列化器
-        template<typename T> requires types::trivial_serializable<T>
-        struct Serializer<T, proto::Trivial> {
-            static constexpr const char *t_str = detail::type_name_of<T>();
+        void check_index(const size_t i) const {
+            if (i >= count_)
+                BSP_THROW(errors::make(errors::code::invalid_index, ctx_,
+                                       detail::concat("index ", i, " out of ", count_, " elements")));
+        }
 
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Trivial"); });
-                w.write_bytes(reinterpret_cast<const uint8_t *>(&v), sizeof(T));
-            }
+        auto guard(const size_t i) const {
+            return ctx_.template guard<true, false, false>([i, this] {
+                return errors::value_frame{
+                    "std::vector", "Indexed", errors::frame_text{"Elem ", i},
+                    errors::frame_text{"length=", count_}
+                };
+            });
+        }
+    };
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str, "Trivial"); });
-                r.read_bytes(reinterpret_cast<uint8_t *>(&out), sizeof(T));
-            }
-        };
 
-        template<typename T> requires types::trivial_serializable<T>
-        struct Serializer<std::vector<T>, proto::Trivial> {
-            static void write(io::Writer auto &w, const std::vector<T> &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::value_frame{
-                        "std::vector", "Trivial", std::nullopt,
-                        detail::concat("length=", v.size())
-                    };
-                });
-                detail::write_varint(w, v.size());
-                w.write_bytes(reinterpret_cast<const uint8_t *>(v.data()), v.size() * sizeof(T));
-            }
+    // === Struct of Arrays ====================================================
+    // 列式存储
+    template<typename T, size_t Version>
+    struct columns {
+        static_assert(types::schema_serializable<T>, "bsp: columns need a schema type");
+        static constexpr size_t index = schema::match_schema_index<T, Version>();
+        static_assert(index != SIZE_MAX, "bsp: no suitable schema under version Version");
 
-            static void read(io::Reader auto &r, std::vector<T> &out, context &ctx) {
-                size_t size = 0;
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::value_frame{
-                        "std::vector", "Trivial", std::nullopt,
-                        detail::concat("length=", size)
-                    };
-                });
-                size = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-                if (ctx.sf.policy <= errors::error_policy::MEDIUM)
-                    if (size > ctx.sf.max_container_size) throw errors::container_too_large(size, ctx);
+        static constexpr const auto &fields = std::get<index>(schema::SchemaSet<T>::schemas).fields;
+        using Fields = detail::entry_fields_t<T, index>;
+        static constexpr size_t count = std::tuple_size_v<Fields>;
 
-                out.resize(size);
-                r.read_bytes(reinterpret_cast<uint8_t *>(out.data()), size * sizeof(T));
-            }
-        };
+        // One std::vector per schema field, in schema order
+        typename detail::column_tuple<Fields>::type data;
 
-        // Bit-compressed with Little-endian style
-        // Has the same behaviour on different platforms.
-        template<>
-        struct Serializer<std::vector<bool>, proto::Trivial> {
-            static void write(io::Writer auto &w, const std::vector<bool> &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::value_frame{
-                        "std::vector<bool>", "Trivial", std::nullopt,
-                        detail::concat("bit count=", v.size())
-                    };
-                });
-                detail::write_varint(w, v.size());
+        [[nodiscard]] size_t size() const { return std::get<0>(data).size(); }
 
-                const size_t byte_count = (v.size() + 7) / 8;
-                for (size_t i = 0; i < byte_count; ++i) {
-                    uint8_t byte = 0;
-                    for (size_t bit = 0; bit < 8 && (i * 8 + bit) < v.size(); ++bit) {
-                        if (v[i * 8 + bit])
-                            byte |= (1u << bit);
-                    }
-                    w.write_byte(byte);
-                }
-            }
+        template<auto Member>
+        [[nodiscard]] auto &get() { return std::get<detail::member_index<T, index, Member>()>(data); }
 
-            static void read(io::Reader auto &r, std::vector<bool> &out, context &ctx) {
-                size_t bit_size = 0;
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::value_frame{
-                        "std::vector<bool>", "Trivial", std::nullopt,
-                        detail::concat("bit count=", bit_size)
-                    };
-                });
-                bit_size = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-                if (ctx.sf.policy <= errors::error_policy::MEDIUM)
-                    if (bit_size > ctx.sf.max_container_size) throw errors::container_too_large(bit_size, ctx);
+        template<auto Member>
+        [[nodiscard]] const auto &get() const { return std::get<detail::member_index<T, index, Member>()>(data); }
 
-                out.resize(bit_size);
-                const size_t byte_count = (bit_size + 7) / 8;
-                for (size_t i = 0; i < byte_count; ++i) {
-                    const uint8_t byte = r.read_byte();
-                    for (size_t bit = 0; bit < 8 && (i * 8 + bit) < bit_size; ++bit) {
-                        out[i * 8 + bit] = (byte & (1u << bit)) != 0;
-                    }
-                }
-            }
-        };
+        void push_back(const T &row) {
+            [&]<size_t... Is>(std::index_sequence<Is...>) {
+                (std::get<Is>(data).push_back(row.*(std::get<Is>(fields).ptr)), ...);
+            }(std::make_index_sequence<count>{});
+        }
+
+        [[nodiscard]] T row(const size_t i) const {
+            T out{};
+            [&]<size_t... Is>(std::index_sequence<Is...>) {
+                ((out.*(std::get<Is>(fields).ptr) = std::get<Is>(data)[i]), ...);
+            }(std::make_index_sequence<count>{});
+            return out;
+        }
+    };
 
-        template<typename T, size_t N> requires types::trivial_serializable<T>
-        struct Serializer<std::array<T, N>, proto::Trivial> {
-            static std::string t_str() {
-                return detail::concat("std::array<", N, ">");
+
+    // === Batch Encoding ======================================================
+    // 批量编码
+    namespace parallel {
+        template<typename T, typename Proto>
+        class batch_encoder {
+            static_assert(types::serializable<T, Proto>, "bsp: batch_encoder needs a serializable type");
+
+        public:
+            explicit batch_encoder(thread_pool &pool, context ctx = context::get_default_context())
+                : pool_(pool), ctx_(std::move(ctx)), contexts_(pool.size() + 1) {
             }
 
-            static void write(io::Writer auto &w, const std::array<T, N> &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str(), "Trivial"); });
-                w.write_bytes(reinterpret_cast<const uint8_t *>(v.data()), N * sizeof(T));
+            // Encodes every message into its own buffer, message(i) holds the bytes of objects[i].
+            // If messages fail, the error of the lowest index is rethrown.
+            void encode(const std::span<const T> objects) {
+                for (auto &c: contexts_) c = ctx_;
+                messages_.resize(objects.size());
+
+                pool_.parallel_for(objects.size(), [&](const size_t i, const size_t worker) {
+                    auto &out = messages_[i];
+                    out.buf.clear();
+                    serialize::Serializer<T, Proto>::write(out, objects[i], contexts_[worker]);
+                });
             }
 
-            static void read(io::Reader auto &r, std::array<T, N> &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::value_frame(t_str(), "Trivial"); });
-                r.read_bytes(reinterpret_cast<uint8_t *>(out.data()), N * sizeof(T));
+            // Encodes every message and concatenates them in order.
+            // [Varint length][message]... , each frame is readable as Limited<Varint, Proto>.
+            const std::vector<uint8_t> &encode_framed(const std::span<const T> objects) {
+                encode(objects);
+
+                io::CountingWriter counter;
+                for (const auto &m: messages_) {
+                    detail::write_varint(counter, m.buf.size());
+                    counter.count += m.buf.size();
+                }
+
+                framed_.buf.clear();
+                framed_.buf.reserve(counter.count);
+                for (const auto &m: messages_) {
+                    detail::write_varint(framed_, m.buf.size());
+                    framed_.write_bytes(m.buf.data(), static_cast<std::streamsize>(m.buf.size()));
+                }
+                return framed_.buf;
             }
+
+            // Messages of the last batch
+            [[nodiscard]] size_t size() const { return messages_.size(); }
+
+            [[nodiscard]] const std::vector<uint8_t> &message(const size_t i) const { return messages_[i].buf; }
+
+        private:
+            thread_pool &pool_;
+            context ctx_;
+            std::vector<context> contexts_;
+            std::vector<io::BufferWriter> messages_;
+            io::BufferWriter framed_;
         };
+    }
 
 
-        // --- Serializers for Pointers ----------------------------------------
-        // 指针的序列化器
-        template<typename T> requires types::default_serializable<T>
-        struct Serializer<T *, proto::Varint> {
-            static void write(io::Writer auto &w, const T *const &v, context &ctx) {
-                auto g = ctx.guard<true, false, false>([] { return errors::wrapper_frame("ptr"); });
+#ifdef BSP_POSIX
+    // === Record Log ==========================================================
+    // 记录日志
+    namespace detail {
+        // CRC-32 (IEEE 802.3), used to detect torn records
+        inline constexpr auto crc32_table = [] {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            return table;
+        }();
+
+        [[nodiscard]] inline uint32_t crc32(const uint8_t *p, const size_t n) {
+            uint32_t c = 0xFFFFFFFFu;
+            for (size_t i = 0; i < n; ++i)
+                c = crc32_table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+            return c ^ 0xFFFFFFFFu;
+        }
 
-                const bool non_null = v != nullptr;
-                w.write_byte(static_cast<uint8_t>(non_null));
+        [[nodiscard]] inline errors::error os_error(const char *what, const std::string &path) {
+            return errors::error(errors::code::runtime_error,
+                                 detail::concat(what, " \"", path, "\": ", std::string(std::strerror(errno))));
+        }
 
-                if (non_null) {
-                    DefaultSerializer<T>::write(w, *v, ctx);
+        // Owns a file descriptor and a shared mapping of the whole file
+        class mapped_file {
+        public:
+            // create_size > 0 creates the file with that size when it is missing or empty
+            mapped_file(const std::string &path, const bool writable, const size_t create_size = 0) {
+                fd_ = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+                if (fd_ < 0) BSP_THROW(os_error("cannot open", path));
+
+                struct stat st{};
+                if (::fstat(fd_, &st) != 0) {
+                    ::close(fd_);
+                    BSP_THROW(os_error("cannot stat", path));
+                }
+                size_ = static_cast<size_t>(st.st_size);
+                if (size_ == 0 && create_size && writable) {
+                    if (::ftruncate(fd_, static_cast<off_t>(create_size)) != 0) {
+                        ::close(fd_);
+                        BSP_THROW(os_error("cannot resize", path));
+                    }
+                    size_ = create_size;
+                    created_ = true;
+                }
+                if (size_ == 0) {
+                    ::close(fd_);
+                    BSP_THROW(errors::error(errors::code::unexpected_eof, detail::concat("empty file \"", path, "\"")));
+                }
+
+                void *p = ::mmap(nullptr, size_, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+                if (p == MAP_FAILED) {
+                    ::close(fd_);
+                    BSP_THROW(os_error("cannot map", path));
                 }
+                data_ = static_cast<uint8_t *>(p);
             }
 
-            static void read(io::Reader auto &r, T *&out, context &ctx) {
-                auto g = ctx.guard<true, false, false>([] { return errors::wrapper_frame("ptr"); });
+            ~mapped_file() {
+                if (data_) ::munmap(data_, size_);
+                if (fd_ >= 0) ::close(fd_);
+            }
 
-                const uint8_t non_null_byte = r.read_byte();
-                if (ctx.sf.policy <= errors::error_policy::STRICT && non_null_byte > 1)
-                    throw errors::invalid_bool(non_null_byte, ctx);
-                const bool non_null = static_cast<bool>(non_null_byte);
+            mapped_file(const mapped_file &) = delete;
 
-                delete out;
-                if (non_null) {
-                    out = new T{};
-                    DefaultSerializer<T>::read(r, *out, ctx);
-                } else {
-                    out = nullptr;
-                }
-            }
-        };
+            mapped_file &operator=(const mapped_file &) = delete;
 
-        template<typename T> requires types::default_serializable<T>
-        struct Serializer<std::unique_ptr<T>, proto::Varint> {
-            static void write(io::Writer auto &w, const std::unique_ptr<T> &v, context &ctx) {
-                auto g = ctx.guard<true, false, false>([] { return errors::wrapper_frame("std::unique_ptr"); });
+            [[nodiscard]] uint8_t *data() const { return data_; }
+            [[nodiscard]] size_t size() const { return size_; }
+            [[nodiscard]] int fd() const { return fd_; }
+            [[nodiscard]] bool created() const { return created_; }
 
-                const bool non_null = v != nullptr;
-                w.write_byte(static_cast<uint8_t>(non_null));
+        private:
+            uint8_t *data_ = nullptr;
+            size_t size_ = 0;
+            int fd_ = -1;
+            bool created_ = false;
+        };
 
-                if (non_null) {
-                    DefaultSerializer<T>::write(w, *v, ctx);
-                }
+        // File:   [Header 64 bytes][Record]...
+        // Header: [magic 8][capacity 8][reserved bytes 8][unused]
+        // Record: [u32 size][u32 crc32][u32 state][u32 sync][payload][padding to 8 bytes]
+        // Header and record words use native byte order, the payload is plain BSP.
+        // A record whose size is 0 ends the log so far, unless a writer died before storing it:
+        // recovery then scans for the sync word of the next record up to the reserved bytes.
+        namespace record_log {
+            inline constexpr uint64_t magic = 0x31474F4C50534201ull; // "\1BSPLOG1"
+            inline constexpr size_t header_size = 64;
+            inline constexpr size_t record_header_size = 16;
+            inline constexpr uint32_t sync_word = 0x43455242u; // "BREC"
+
+            enum state : uint32_t {
+                pending = 0,
+                committed = 1,
+                aborted = 2
+            };
+
+            [[nodiscard]] constexpr size_t record_size(const size_t payload) {
+                return record_header_size + (payload + 7) / 8 * 8;
             }
 
-            static void read(io::Reader auto &r, std::unique_ptr<T> &out, context &ctx) {
-                auto g = ctx.guard<true, false, false>([] { return errors::wrapper_frame("std::unique_ptr"); });
+            [[nodiscard]] inline uint64_t *word64(uint8_t *base, const size_t offset) {
+                return reinterpret_cast<uint64_t *>(base + offset);
+            }
 
-                const uint8_t non_null_byte = r.read_byte();
-                if (ctx.sf.policy <= errors::error_policy::STRICT && non_null_byte > 1)
-                    throw errors::invalid_bool(non_null_byte, ctx);
-                const bool non_null = static_cast<bool>(non_null_byte);
+            [[nodiscard]] inline uint32_t *word32(uint8_t *base, const size_t offset) {
+                return reinterpret_cast<uint32_t *>(base + offset);
+            }
+        }
+    }
 
-                if (non_null) {
-                    out = std::make_unique<T>();
-                    DefaultSerializer<T>::read(r, *out, ctx);
-                } else {
-                    out.reset();
+    namespace io {
+        class RecordLog {
+        public:
+            // Opens the log at path, or creates it with room for capacity bytes of records
+            RecordLog(const std::string &path, const size_t capacity)
+                : file_(path, true, detail::record_log::header_size + capacity) {
+                using namespace detail::record_log;
+                uint8_t *base = file_.data();
+                if (file_.created()) {
+                    *word64(base, 8) = file_.size() - header_size;
+                    *word64(base, 16) = 0;
+                    std::atomic_ref(*word64(base, 0)).store(magic, std::memory_order_release);
+                } else if (file_.size() < header_size || *word64(base, 0) != magic) {
+                    BSP_THROW(errors::error(errors::code::invalid_index,
+                                            detail::concat("\"", path, "\" is not a record log")));
                 }
+                capacity_ = *word64(base, 8);
+            }
+
+            // Appends one record and returns its offset. Safe to call from many threads.
+            // The value is encoded twice: once to count its size, then directly into the reserved region.
+            template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
+            uint64_t append(const T &v, context &ctx) {
+                using namespace detail::record_log;
+
+                io::CountingWriter counter;
+                serialize::Serializer<T, Proto>::write(counter, v, ctx);
+                if (counter.count == 0 || counter.count > UINT32_MAX)
+                    BSP_THROW(errors::make(errors::code::fixed_size_mismatch, ctx,
+                                           detail::concat("record size ", counter.count, " out of range")));
+
+                const size_t need = record_size(counter.count);
+                const uint64_t offset = reserved().fetch_add(need, std::memory_order_acq_rel);
+                if (offset + need > capacity_)
+                    BSP_THROW(errors::make(errors::code::runtime_error, ctx,
+                                           detail::concat("record log full (capacity ", capacity_, " bytes)")));
+
+                uint8_t *rec = file_.data() + header_size + offset;
+                *word32(rec, 12) = sync_word;
+                std::atomic_ref(*word32(rec, 0)).store(static_cast<uint32_t>(counter.count),
+                                                       std::memory_order_release);
+                BSP_TRY {
+                    SpanWriter w(rec + record_header_size, counter.count);
+                    serialize::Serializer<T, Proto>::write(w, v, ctx);
+                    if (w.pos != counter.count)
+                        BSP_THROW(errors::make(errors::code::fixed_size_mismatch, ctx,
+                                               detail::concat("record wrote ", w.pos, " of ", counter.count,
+                                                              " bytes")));
+                } BSP_CATCH_ALL {
+                    std::atomic_ref(*word32(rec, 8)).store(aborted, std::memory_order_release);
+                    BSP_RETHROW;
+                }
+
+                *word32(rec, 4) = detail::crc32(rec + record_header_size, counter.count);
+                std::atomic_ref(*word32(rec, 8)).store(committed, std::memory_order_release);
+                return offset;
             }
-        };
 
+            template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
+            uint64_t append(const T &v) {
+                auto ctx = context::get_default_context();
+                return append<Proto>(v, ctx);
+            }
 
-        // ~~~ Serializers for Protocols ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-        // 为特定协议设计的序列化器
+            // Group commit: makes every record committed before this call durable.
+            // Callers arriving while another sync runs share the next msync instead of issuing one each.
+            void sync() {
+                const uint64_t ticket = started_.load(std::memory_order_acquire);
+                std::lock_guard lock(sync_mutex_);
+                if (completed_ > ticket) return;
 
-        // --- Default Fallback ------------------------------------------------
-        // 默认协议映射
-        template<typename T> requires (!std::is_same_v<T, proto::Default> && types::default_serializable<T>)
-        struct Serializer<T, proto::Default> {
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                DefaultSerializer<T>::write(w, v, ctx);
+                started_.fetch_add(1, std::memory_order_acq_rel);
+                // Records may commit in any order, so the whole used range is synced; clean pages cost little
+                const size_t used = detail::record_log::header_size + std::min(reserved().load(), capacity_);
+                if (::msync(file_.data(), used, MS_SYNC) != 0)
+                    BSP_THROW(errors::error(errors::code::runtime_error,
+                                            detail::concat("msync failed: ", std::string(std::strerror(errno)))));
+                ++completed_;
             }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                DefaultSerializer<T>::read(r, out, ctx);
+            // Bytes reserved by all writers so far
+            [[nodiscard]] uint64_t size() const { return std::min(reserved().load(), capacity_); }
+
+            [[nodiscard]] uint64_t capacity() const { return capacity_; }
+
+        private:
+            [[nodiscard]] std::atomic_ref<uint64_t> reserved() const {
+                return std::atomic_ref(*detail::record_log::word64(file_.data(), 16));
             }
+
+            detail::mapped_file file_;
+            uint64_t capacity_ = 0;
+
+            std::mutex sync_mutex_;
+            std::atomic<uint64_t> started_{0};
+            uint64_t completed_ = 0;
         };
 
-        // --- Serializers for Length-Limited Protocols ------------------------
-        // 限定长度的协议的序列化器
+        class RecordLogReader {
+        public:
+            // With recover set, pending records and records whose size was never stored are treated as
+            // abandoned by a crashed writer and skipped.
+            // Otherwise the reader stops at such a record and continues there on the next call.
+            explicit RecordLogReader(const std::string &path, const bool recover = false)
+                : file_(path, false), recover_(recover) {
+                using namespace detail::record_log;
+                if (file_.size() < header_size || *word64(file_.data(), 0) != magic)
+                    BSP_THROW(errors::error(errors::code::invalid_index,
+                                            detail::concat("\"", path, "\" is not a record log")));
+                capacity_ = std::min<uint64_t>(*word64(file_.data(), 8), file_.size() - header_size);
+            }
+
+            // Payload of the next committed record, or nullopt when no more records are ready yet
+            [[nodiscard]] std::optional<std::span<const uint8_t> > next() {
+                using namespace detail::record_log;
+                while (pos_ + record_header_size <= capacity_) {
+                    uint8_t *rec = file_.data() + header_size + pos_;
+                    const uint32_t size = std::atomic_ref(*word32(rec, 0)).load(std::memory_order_acquire);
+                    if (size == 0) {
+                        if (recover_ && resync()) continue;
+                        return std::nullopt;
+                    }
 
-        // proto::Limited
+                    const size_t step = record_size(size);
+                    if (pos_ + step > capacity_) return std::nullopt;
 
-        // [Varint length][Inner payload]
-        template<typename T, typename Inner> requires types::serializable<T, Inner>
-        struct Serializer<T, proto::Limited<proto::Varint, Inner> > {
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::wrapper_frame("Limited<Varint>"); });
+                    const uint32_t st = std::atomic_ref(*word32(rec, 8)).load(std::memory_order_acquire);
+                    if (st == pending && !recover_) return std::nullopt;
 
-                // Write to temporary buffer to know the size
-                io::BufferWriter tmp;
-                Serializer<T, Inner>::write(tmp, v, ctx);
+                    pos_ += step;
+                    if (st == committed && detail::crc32(rec + record_header_size, size) == *word32(rec, 4))
+                        return std::span<const uint8_t>(rec + record_header_size, size);
+                    ++skipped_;
+                }
+                return std::nullopt;
+            }
 
-                detail::write_varint(w, tmp.buf.size());
-                w.write_bytes(tmp.buf.data(), tmp.buf.size());
+            // Decodes the next committed record into out, returns false when no record is ready
+            template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
+            bool next(T &out, context &ctx) {
+                const auto rec = next();
+                if (!rec) return false;
+                BytesReader r(rec->data(), rec->size());
+                serialize::Serializer<T, Proto>::read(r, out, ctx);
+                return true;
             }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                size_t len = 0;
-                auto g = ctx.guard<false, false, false>([&] {
-                    return errors::wrapper_frame{detail::concat("Limited<Varint> size=", len)};
-                });
+            template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
+            bool next(T &out) {
+                auto ctx = context::get_default_context();
+                return next<Proto>(out, ctx);
+            }
 
-                len = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-                io::LimitedReader limited_r(r, len);
-                Serializer<T, Inner>::read(limited_r, out, ctx);
+            // Offset of the next record
+            [[nodiscard]] uint64_t position() const { return pos_; }
+
+            // Aborted, torn and (with recover) pending records and holes skipped so far
+            [[nodiscard]] size_t skipped() const { return skipped_; }
+
+        private:
+            // Moves pos_ past a hole left by a writer that died before storing the size of its record,
+            // to the next committed record within the reserved bytes. False when there is none.
+            bool resync() {
+                using namespace detail::record_log;
+                const uint64_t end = std::min(std::atomic_ref(*word64(file_.data(), 16)).load(
+                                                  std::memory_order_acquire), capacity_);
+                for (uint64_t at = pos_ + 8; at + record_header_size <= end; at += 8) {
+                    uint8_t *rec = file_.data() + header_size + at;
+                    const uint32_t size = std::atomic_ref(*word32(rec, 0)).load(std::memory_order_acquire);
+                    // A sync word inside a payload fails the CRC, so the scan goes on
+                    if (size == 0 || *word32(rec, 12) != sync_word || at + record_size(size) > end ||
+                        std::atomic_ref(*word32(rec, 8)).load(std::memory_order_acquire) != committed ||
+                        detail::crc32(rec + record_header_size, size) != *word32(rec, 4))
+                        continue;
+                    pos_ = at;
+                    ++skipped_;
+                    return true;
+                }
+                return false;
             }
+
+            detail::mapped_file file_;
+            bool recover_;
+            uint64_t capacity_ = 0;
+            uint64_t pos_ = 0;
+            size_t skipped_ = 0;
         };
+    }
 
-        // [Inner payload]
-        template<typename T, size_t N, typename Inner> requires types::serializable<T, Inner>
-        struct Serializer<T, proto::Limited<proto::Fixed<N>, Inner> > {
-            static std::string p_str() { return detail::concat("Limited<Fixed<", N, ">>"); }
+    // === Mapped Files ========================================================
+    // 文件映射
+    namespace io {
+        /**
+         * @brief Map a file read-only as a types::slice.
+         * @details The mapping stays alive as long as any slice shares it. Read it with a SliceReader to
+         * decode types::slice fields straight out of the mapping.
+         * @param path Path of the file, which must not be empty.
+         */
+        [[nodiscard]] inline types::slice map_file(const std::string &path) {
+            auto file = std::make_shared<const detail::mapped_file>(path, false);
+            return {file, file->data(), file->size()};
+        }
+    }
 
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::wrapper_frame(p_str()); });
+    // === Shared-Memory Ring ==================================================
+    // 共享内存环形缓冲区
+    namespace detail {
+        // File:    [Header 256 bytes][Data, capacity bytes]
+        // Header:  [magic 8][capacity 8][multi_producer 8] then one cache line each for
+        //          reserved (producers), published (producers) and consumed (consumer) positions
+        // Message: [u32 size][u32 dropped][payload][padding to 8 bytes]
+        // Positions grow forever and wrap by capacity (a power of two). A message never wraps:
+        // when it does not fit before the end, a wrap marker fills the rest of the lap.
+        namespace shm_ring {
+            inline constexpr uint64_t magic = 0x31474E4950534201ull; // "\1BSPING1"
+            inline constexpr size_t header_size = 256;
+            inline constexpr size_t message_header_size = 8;
+            inline constexpr uint32_t wrap_marker = UINT32_MAX;
 
-                io::BufferWriter tmp;
-                Serializer<T, Inner>::write(tmp, v, ctx);
+            inline constexpr size_t reserved_offset = 64;
+            inline constexpr size_t published_offset = 128;
+            inline constexpr size_t consumed_offset = 192;
 
-                if (tmp.buf.size() > N)
-                    throw errors::fixed_size_mismatch(N, tmp.buf.size(), ctx);
+            static_assert(std::atomic_ref<uint64_t>::is_always_lock_free, "bsp: shared rings need lock-free atomics");
 
-                w.write_bytes(tmp.buf.data(), tmp.buf.size());
+            [[nodiscard]] constexpr size_t message_size(const size_t payload) {
+                return message_header_size + (payload + 7) / 8 * 8;
             }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::wrapper_frame(p_str()); });
-
-                const size_t len = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
-                if (len > N)
-                    throw errors::fixed_size_mismatch(N, len, ctx);
+            [[nodiscard]] inline std::atomic_ref<uint64_t> position(uint8_t *base, const size_t offset) {
+                return std::atomic_ref(*reinterpret_cast<uint64_t *>(base + offset));
+            }
 
-                io::LimitedReader limited_r(r, len);
-                Serializer<T, Inner>::read(limited_r, out, ctx);
+            inline void check(const mapped_file &file, const std::string &path) {
+                if (file.size() < header_size || *record_log::word64(file.data(), 0) != magic)
+                    BSP_THROW(errors::error(errors::code::invalid_index,
+                                            detail::concat("\"", path, "\" is not a ring")));
             }
-        };
+        }
+    }
 
-        // proto::Forced
+    namespace io {
+        // Creates (or replaces) a ring at path. capacity is rounded up to a power of two.
+        // A path on tmpfs (e.g. /dev/shm on Linux) keeps the ring in memory.
+        inline void create_shm_ring(const std::string &path, const size_t capacity, const bool multi_producer = false) {
+            using namespace detail::shm_ring;
+            ::unlink(path.c_str());
+            const size_t data_size = std::bit_ceil(std::max<size_t>(capacity, 64));
+            detail::mapped_file file(path, true, header_size + data_size);
+            *detail::record_log::word64(file.data(), 8) = data_size;
+            *detail::record_log::word64(file.data(), 16) = multi_producer;
+            position(file.data(), 0).store(magic, std::memory_order_release);
+        }
 
-        // [Varint length][Inner payload padded with zero]
-        template<typename T, typename Inner> requires types::serializable<T, Inner>
-        struct Serializer<T, proto::Forced<proto::Varint, Inner> > {
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::wrapper_frame("Forced<Varint>"); });
+        class ShmRingWriter {
+        public:
+            explicit ShmRingWriter(const std::string &path) : file_(path, true) {
+                using namespace detail::shm_ring;
+                check(file_, path);
+                capacity_ = *detail::record_log::word64(file_.data(), 8);
+                multi_producer_ = *detail::record_log::word64(file_.data(), 16);
+                data_ = file_.data() + header_size;
+            }
+
+            // Encodes one message straight into the ring, waiting while the ring is full.
+            // The value is encoded twice: once to count its size, then into the reserved space.
+            template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
+            void send(const T &v, context &ctx) {
+                io::CountingWriter counter;
+                serialize::Serializer<T, Proto>::write(counter, v, ctx);
+
+                uint8_t *payload = reserve(counter.count, ctx);
+                SpanWriter w(payload, counter.count);
+                BSP_TRY {
+                    serialize::Serializer<T, Proto>::write(w, v, ctx);
+                } BSP_CATCH_ALL {
+                    // The space is already taken, the consumer skips the dropped message
+                    constexpr uint32_t dropped = 1;
+                    std::memcpy(payload - sizeof(dropped), &dropped, sizeof(dropped));
+                    publish();
+                    BSP_RETHROW;
+                }
+                publish();
+            }
 
-                // Write to temp buffer, then declare the length
-                io::BufferWriter tmp;
-                Serializer<T, Inner>::write(tmp, v, ctx);
+            template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
+            void send(const T &v) {
+                auto ctx = context::get_default_context();
+                send<Proto>(v, ctx);
+            }
 
-                detail::write_varint(w, tmp.buf.size());
-                w.write_bytes(tmp.buf.data(), tmp.buf.size());
+            // io::Writer: bytes are staged locally and sent as one message by commit()
+            void write_bytes(const uint8_t *buf, const std::streamsize n) {
+                staging_.insert(staging_.end(), buf, buf + n);
             }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                size_t len = 0;
-                io::LimitedReader limited_r(r, 0);
-                auto g = ctx.guard<false, false, false>([&] {
-                    limited_r.skip_remaining();
-                    return errors::wrapper_frame{detail::concat("Limited<Varint> size=", len)};
-                });
+            void write_byte(const uint8_t b) {
+                staging_.push_back(b);
+            }
 
-                len = detail::read_varint<size_t>(r, ctx.sf.policy <= errors::error_policy::MEDIUM);
+            void commit() {
+                auto ctx = context::get_default_context();
+                std::memcpy(reserve(staging_.size(), ctx), staging_.data(), staging_.size());
+                publish();
+                staging_.clear();
+            }
 
-                limited_r.remaining = len;
-                Serializer<T, Inner>::read(limited_r, out, ctx);
-                limited_r.skip_remaining();
+            // Largest payload a single message can carry
+            [[nodiscard]] size_t max_message_size() const {
+                return capacity_ / 2 - detail::shm_ring::message_header_size;
             }
+
+        private:
+            // Returns where the payload goes; publish() must follow
+            uint8_t *reserve(const size_t size, context &ctx) {
+                using namespace detail::shm_ring;
+                if (size > max_message_size())
+                    BSP_THROW(errors::make(errors::code::fixed_size_mismatch, ctx,
+                                           detail::concat("message size ", size, " larger than ring limit ",
+                                                          max_message_size())));
+
+                const size_t need = message_size(size);
+                auto reserved = position(file_.data(), reserved_offset);
+                auto consumed = position(file_.data(), consumed_offset);
+
+                uint64_t start = reserved.load(std::memory_order_relaxed);
+                uint64_t total = 0;
+                while (true) {
+                    const size_t room = capacity_ - (start & (capacity_ - 1));
+                    total = need <= room ? need : room + need;
+                    if (start + total - consumed.load(std::memory_order_acquire) > capacity_) {
+                        std::this_thread::yield();
+                        start = reserved.load(std::memory_order_relaxed);
+                        continue;
+                    }
+                    if (!multi_producer_) {
+                        reserved.store(start + total, std::memory_order_relaxed);
+                        break;
+                    }
+                    if (reserved.compare_exchange_weak(start, start + total, std::memory_order_relaxed))
+                        break;
+                }
+
+                start_ = start;
+                end_ = start + total;
+                uint64_t at = start;
+                if (total != need) {
+                    std::memcpy(data_ + (at & (capacity_ - 1)), &wrap_marker, sizeof(wrap_marker));
+                    at += total - need;
+                }
+                const uint32_t header[2] = {static_cast<uint32_t>(size), 0};
+                std::memcpy(data_ + (at & (capacity_ - 1)), header, sizeof(header));
+                return data_ + (at & (capacity_ - 1)) + message_header_size;
+            }
+
+            // Messages are published in reservation order, so the consumer only follows one position
+            void publish() {
+                using namespace detail::shm_ring;
+                auto published = position(file_.data(), published_offset);
+                if (multi_producer_)
+                    while (published.load(std::memory_order_acquire) != start_)
+                        std::this_thread::yield();
+                published.store(end_, std::memory_order_release);
+            }
+
+            detail::mapped_file file_;
+            uint8_t *data_ = nullptr;
+            uint64_t capacity_ = 0;
+            bool multi_producer_ = false;
+            uint64_t start_ = 0;
+            uint64_t end_ = 0;
+            std::vector<uint8_t> staging_;
         };
 
-        // [Inner payload padded with zero]
-        template<typename T, size_t N, typename Inner> requires types::serializable<T, Inner>
-        struct Serializer<T, proto::Forced<proto::Fixed<N>, Inner> > {
-            static std::string p_str() { return detail::concat("Forced<Fixed<", N, ">>"); }
+        class ShmRingReader {
+        public:
+            explicit ShmRingReader(const std::string &path) : file_(path, true) {
+                using namespace detail::shm_ring;
+                check(file_, path);
+                capacity_ = *detail::record_log::word64(file_.data(), 8);
+                data_ = file_.data() + header_size;
+                end_ = position(file_.data(), consumed_offset).load(std::memory_order_acquire);
+            }
+
+            // Releases the current message and makes the next one current. False when none is ready.
+            bool try_next() {
+                using namespace detail::shm_ring;
+                release();
+                const uint64_t published = position(file_.data(), published_offset).load(std::memory_order_acquire);
+                while (end_ != published) {
+                    uint64_t at = end_;
+                    uint32_t header[2];
+                    std::memcpy(header, data_ + (at & (capacity_ - 1)), sizeof(header[0]));
+                    if (header[0] == wrap_marker)
+                        at += capacity_ - (at & (capacity_ - 1));
+                    std::memcpy(header, data_ + (at & (capacity_ - 1)), sizeof(header));
+
+                    message_ = data_ + (at & (capacity_ - 1)) + message_header_size;
+                    size_ = header[0];
+                    pos_ = 0;
+                    end_ = at + message_size(header[0]);
+                    current_ = true;
+                    if (!header[1]) return true;
+                    release();
+                }
+                return false;
+            }
 
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                auto g = ctx.guard<false, false, false>([] { return errors::wrapper_frame(p_str()); });
+            // Waits for the next message
+            void next() {
+                while (!try_next())
+                    std::this_thread::yield();
+            }
 
-                io::LimitedWriter limited_w(w, N);
-                Serializer<T, Inner>::write(limited_w, v, ctx);
-                limited_w.pad_zero();
+            template<typename T, typename Proto = proto::Default> requires types::serializable<T, Proto>
+            [[nodiscard]] T receive(context &ctx) {
+                next();
+                T out{};
+                serialize::Serializer<T, Proto>::read(*this, out, ctx);
+                return out;
             }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                io::LimitedReader limited_r(r, N);
-                auto g = ctx.guard<false, false, false>([&] {
-                    limited_r.skip_remaining();
-                    return errors::wrapper_frame(p_str());
-                });
+            template<typename T, typename Proto = proto::Default> requires types::serializable<T, Proto>
+            [[nodiscard]] T receive() {
+                auto ctx = context::get_default_context();
+                return receive<T, Proto>(ctx);
+            }
 
-                Serializer<T, Inner>::read(limited_r, out, ctx);
-                limited_r.skip_remaining();
+            // Hands the space of the current message back to the producers
+            void release() {
+                if (!current_) return;
+                detail::shm_ring::position(file_.data(), detail::shm_ring::consumed_offset)
+                        .store(end_, std::memory_order_release);
+                current_ = false;
+                size_ = pos_ = 0;
             }
-        };
 
+            // io::Reader over the current message
+            void read_bytes(uint8_t *buf, const std::streamsize n) {
+                std::memcpy(buf, borrow_bytes(static_cast<size_t>(n)), static_cast<size_t>(n));
+            }
 
-        // ~~~ Syntactic Sugar: Registered Inside Type ~~~~~~~~~~~~~~~~~~~~~~~~~
-        // 语法糖：类内注册
-        template<typename T, typename P> requires types::internal_serializable<T, P>
-        struct Serializer<T, P> {
-            static void write(io::Writer auto &w, const T &v, context &ctx) {
-                T::write(w, v, ctx, P{});
+            [[nodiscard]] uint8_t read_byte() {
+                if (pos_ >= size_)
+                    BSP_THROW(errors::unexpected_eof(1, 0, "ShmRingReader"));
+                return message_[pos_++];
             }
 
-            static void read(io::Reader auto &r, T &out, context &ctx) {
-                T::read(r, out, ctx, P{});
+            [[nodiscard]] const uint8_t *borrow_bytes(const size_t n) {
+                if (n > size_ - pos_)
+                    BSP_THROW(errors::unexpected_eof(n, size_ - pos_, "ShmRingReader"));
+                const uint8_t *p = message_ + pos_;
+                pos_ += n;
+                return p;
             }
+
+            // Unread bytes of the current message
+            [[nodiscard]] size_t remaining() const { return size_ - pos_; }
+
+        private:
+            detail::mapped_file file_;
+            uint8_t *data_ = nullptr;
+            uint64_t capacity_ = 0;
+
+            const uint8_t *message_ = nullptr;
+            size_t size_ = 0;
+            size_t pos_ = 0;
+            uint64_t end_ = 0;
+            bool current_ = false;
         };
     }
+#endif
 
 
     /* =========================================================================
@@ -2972,7 +7665,7 @@ namespace bsp {
     // They SHOULD NOT be used in serializers!
 
     template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
-    void write(io::Writer auto &w, const T &v, context &ctx) {
+    void write(io::Writer auto &w, const T &v, context_like auto &ctx) {
         serialize::Serializer<T, Proto>::write(w, v, ctx);
     }
 
@@ -2984,7 +7677,7 @@ namespace bsp {
 
 
     template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
-    void read(io::Reader auto &r, T &out, context &ctx) {
+    void read(io::Reader auto &r, T &out, context_like auto &ctx) {
         serialize::Serializer<T, Proto>::read(r, out, ctx);
     }
 
@@ -3003,11 +7696,184 @@ namespace bsp {
     }
 
     template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
-    [[nodiscard]] T read(io::Reader auto &r, context &ctx) {
+    [[nodiscard]] T read(io::Reader auto &r, context_like auto &ctx) {
         T out{};
         serialize::Serializer<T, Proto>::read(r, out, ctx);
         return out;
     }
+
+    // === Checked Functions ===================================================
+    // 返回错误码的函数
+    // Errors in the data come back as errors::code, nothing is thrown or unwound on the way.
+    // Exceptions from custom serializers and allocations still propagate.
+    // Example: if (auto m = bsp::try_read<Packet>(reader)) handle(*m); else drop(m.error());
+
+    // The first error is also kept in r.error, r is left where decoding stopped
+    template<typename T, typename Proto = proto::Default> requires types::serializable<T, Proto>
+    [[nodiscard]] result<T> try_read(io::CheckedReader &r, context_like auto &ctx) {
+        T out{};
+        {
+            detail::failure_scope scope(ctx, r.error);
+            serialize::Serializer<T, Proto>::read(r, out, ctx);
+        }
+        if (r.error) return *r.error;
+        return out;
+    }
+
+    // Reads the unread bytes of r, which only advances on success
+    template<typename T, typename Proto = proto::Default> requires types::serializable<T, Proto>
+    [[nodiscard]] result<T> try_read(io::BytesReader &r, context_like auto &ctx) {
+        io::CheckedReader checked(r.data + r.pos, r.size - r.pos);
+        auto out = try_read<T, Proto>(checked, ctx);
+        if (out) r.pos += checked.pos;
+        return out;
+    }
+
+    template<typename T, typename Proto = proto::Default, typename R>
+        requires types::serializable<T, Proto> &&
+                 (std::same_as<R, io::CheckedReader> || std::same_as<R, io::BytesReader>)
+    [[nodiscard]] result<T> try_read(R &r) {
+        auto ctx = context::get_default_context();
+        return try_read<T, Proto>(r, ctx);
+    }
+
+    // Running out of space is returned as well when w is a CheckedWriter. Output written before an error is kept.
+    template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
+    [[nodiscard]] result<void> try_write(io::Writer auto &w, const T &v, context_like auto &ctx) {
+        std::optional<errors::code> error;
+        {
+            detail::failure_scope scope(ctx, error);
+            serialize::Serializer<T, Proto>::write(w, v, ctx);
+        }
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(w)>, io::CheckedWriter>)
+            if (!error) error = w.error;
+        if (error) return *error;
+        return {};
+    }
+
+    template<typename Proto = proto::Default, typename T> requires types::serializable<T, Proto>
+    [[nodiscard]] result<void> try_write(io::Writer auto &w, const T &v) {
+        auto ctx = context::get_default_context();
+        return try_write<Proto>(w, v, ctx);
+    }
+
+    // === Projection Functions ================================================
+    // 投影函数
+    // Read a schema struct written with its default protocol, decoding only Members.
+    // The other fields are skipped and keep their default values, the whole message is consumed.
+    // Example: auto t = bsp::read_fields<Trade, &Trade::price, &Trade::qty>(reader);
+
+    template<typename T, auto... Members> requires types::schema_serializable<T>
+    [[nodiscard]] T read_fields(io::Reader auto &r, context_like auto &ctx) {
+        using P = proto::DefaultProtocol_t<T>;
+        static_assert(detail::is_schema_proto<P>::value, "bsp: projection needs a Schema<V> default protocol");
+        constexpr size_t index = schema::match_schema_index<T, detail::is_schema_proto<P>::version>();
+        static_assert((detail::in_schema<T, index, Members>() && ...), "bsp: projected member is not in the schema");
+
+        T out{};
+        [[maybe_unused]] const char *current_field = nullptr;
+        auto g = ctx.template guard<true, false, false>([&] {
+            return errors::value_frame{
+                .type = schema::SchemaSet<T>::Typename,
+                .proto = "Projection",
+                .child_label = current_field
+                                   ? errors::frame_text{"Field \"", current_field, "\""}
+                                   : errors::frame_text{},
+                .details = errors::frame_text{"exact version ", std::get<index>(schema::SchemaSet<T>::schemas).version}
+            };
+        });
+        detail::project_fields_from<T, index, 0, Members...>(r, out, ctx, current_field);
+        return out;
+    }
+
+    template<typename T, auto... Members> requires types::schema_serializable<T>
+    [[nodiscard]] T read_fields(io::Reader auto &r) {
+        auto ctx = context::get_default_context();
+        return read_fields<T, Members...>(r, ctx);
+    }
+
+    // === Batch Functions =====================================================
+    // 批量函数
+    // Write/read many values back to back with one context and one guard for the whole batch.
+    // The runtime error policy is resolved once per batch, the values are then coded with it fixed.
+    // Size and depth limits depend on each value and are still checked per value.
+    // The bytes are the same as calling write/read for every value.
+    // Example: bsp::write_batch(writer, orders, ctx);
+    //          auto orders = bsp::read_batch<Order>(reader, n, ctx);
+
+    template<typename Proto = proto::Default, std::ranges::input_range Range>
+        requires types::serializable<std::ranges::range_value_t<Range>, Proto>
+    void write_batch(io::Writer auto &w, const Range &values, context_like auto &ctx) {
+        using T = std::ranges::range_value_t<Range>;
+
+        if constexpr (detail::fixed_width<T, Proto> && std::ranges::contiguous_range<Range>) {
+            detail::write_fixed_array<T, Proto>(w, std::ranges::data(values), std::ranges::size(values));
+        } else {
+            detail::with_fixed_policy(ctx, [&](auto &batch_ctx) {
+                size_t i = 0;
+                auto g = batch_ctx.template guard<false, false, false>([&] {
+                    return errors::wrapper_frame{errors::frame_text{"batch index=", i}};
+                });
+                for (const auto &v: values) {
+                    serialize::Serializer<T, Proto>::write(w, v, batch_ctx);
+                    ++i;
+                }
+            });
+        }
+    }
+
+    template<typename Proto = proto::Default, std::ranges::input_range Range>
+        requires types::serializable<std::ranges::range_value_t<Range>, Proto>
+    void write_batch(io::Writer auto &w, const Range &values) {
+        auto ctx = context::get_default_context();
+        write_batch<Proto>(w, values, ctx);
+    }
+
+
+    // Fills every element of out
+    template<typename Proto = proto::Default, std::ranges::forward_range Range>
+        requires types::serializable<std::ranges::range_value_t<Range>, Proto>
+    void read_batch(io::Reader auto &r, Range &&out, context_like auto &ctx) {
+        using T = std::ranges::range_value_t<Range>;
+
+        if constexpr (detail::fixed_width<T, Proto> && std::ranges::contiguous_range<Range>) {
+            auto g = ctx.template guard<false, false, false>([&] {
+                return errors::wrapper_frame{errors::frame_text{"batch size=", std::ranges::size(out)}};
+            });
+            detail::read_fixed_array<T, Proto>(r, std::ranges::data(out), std::ranges::size(out), ctx);
+        } else {
+            detail::with_fixed_policy(ctx, [&](auto &batch_ctx) {
+                size_t i = 0;
+                auto g = batch_ctx.template guard<false, false, false>([&] {
+                    return errors::wrapper_frame{errors::frame_text{"batch index=", i}};
+                });
+                for (auto &v: out) {
+                    serialize::Serializer<T, Proto>::read(r, v, batch_ctx);
+                    ++i;
+                }
+            });
+        }
+    }
+
+    template<typename Proto = proto::Default, std::ranges::forward_range Range>
+        requires types::serializable<std::ranges::range_value_t<Range>, Proto>
+    void read_batch(io::Reader auto &r, Range &&out) {
+        auto ctx = context::get_default_context();
+        read_batch<Proto>(r, std::forward<Range>(out), ctx);
+    }
+
+    template<typename T, typename Proto = proto::Default> requires types::serializable<T, Proto>
+    [[nodiscard]] std::vector<T> read_batch(io::Reader auto &r, const size_t n, context_like auto &ctx) {
+        std::vector<T> out(n);
+        read_batch<Proto>(r, out, ctx);
+        return out;
+    }
+
+    template<typename T, typename Proto = proto::Default> requires types::serializable<T, Proto>
+    [[nodiscard]] std::vector<T> read_batch(io::Reader auto &r, const size_t n) {
+        auto ctx = context::get_default_context();
+        return read_batch<T, Proto>(r, n, ctx);
+    }
 } // namespace bsp
 
 
@@ -3026,8 +7892,14 @@ namespace bsp {
         }                                                                      \
     }
 
+#define BSP_FIELD_ID_P(F, Id, P) \
+    ::bsp::schema::Field<Type, decltype(std::declval<Type>().F), P>{#F, &Type::F, Id}
+
+#define BSP_FIELD_ID(F, Id) \
+    BSP_FIELD_ID_P(F, Id, ::bsp::proto::Default)
+
 #define BSP_FIELD_P(F, P) \
-    ::bsp::schema::Field<Type, decltype(std::declval<Type>().F), P>{#F, &Type::F}
+    BSP_FIELD_ID_P(F, 0, P)
 
 #define BSP_FIELD(F) \
     BSP_FIELD_P(F, ::bsp::proto::Default)
@@ -10,6 +10,14 @@
 #include <bitset>
 #include <array>
 #include <memory>
+#include <memory_resource>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#ifdef BSP_POSIX
+#include <sys/socket.h>
+#endif
 
 // ============================================================================
 // 测试用的结构体，带 Schema 定义
@@ -40,6 +48,17 @@ BSP_SCHEMA_SET(Person,
                BSP_SCHEMA_V(2, PERSON_FIELDS_V2)
 );
 
+// 只认识 V1 的旧版本结构体
+struct PersonV1 {
+    std::string name;
+    int age;
+    bool active;
+};
+
+BSP_SCHEMA_SET(PersonV1,
+               BSP_SCHEMA_V(1, BSP_FIELD(name), BSP_FIELD(age), BSP_FIELD(active))
+);
+
 // ============================================================================
 // 另一个测试用的结构体，使用 PVal 覆盖协议
 // ============================================================================
@@ -53,6 +72,162 @@ BSP_SCHEMA_SET(Data,
                BSP_SCHEMA(BSP_FIELD(id), BSP_FIELD(payload))
 );
 
+// ============================================================================
+// 内存布局与线格式一致的结构体（memcpy 快速路径）
+// ============================================================================
+
+struct Pixel {
+    uint8_t r, g, b, a;
+};
+
+BSP_SCHEMA_SET(Pixel,
+               BSP_SCHEMA(BSP_FIELD(r), BSP_FIELD(g), BSP_FIELD(b), BSP_FIELD(a))
+);
+
+struct Sample {
+    int32_t id;
+    float value;
+};
+
+BSP_SCHEMA_SET(Sample,
+               BSP_SCHEMA(BSP_FIELD_P(id, bsp::proto::Trivial), BSP_FIELD_P(value, bsp::proto::Trivial))
+);
+
+struct Swapped {
+    uint8_t x, y;
+};
+
+BSP_SCHEMA_SET(Swapped,
+               BSP_SCHEMA(BSP_FIELD(y), BSP_FIELD(x))
+);
+
+struct Padded {
+    uint8_t tag;
+    uint32_t value;
+};
+
+BSP_SCHEMA_SET(Padded,
+               BSP_SCHEMA(BSP_FIELD(tag), BSP_FIELD_P(value, bsp::proto::Trivial))
+);
+
+// ============================================================================
+// 定长字段与变长字段混合的结构体（定长段合并边界检查）
+// ============================================================================
+
+struct Order {
+    uint64_t id;
+    int32_t qty;
+    double price;
+    std::string symbol;
+    bool buy;
+    uint16_t venue;
+    std::array<int16_t, 3> legs;
+    std::vector<uint32_t> fills;
+};
+
+BSP_SCHEMA_SET(Order,
+               BSP_SCHEMA(BSP_FIELD(id), BSP_FIELD(qty), BSP_FIELD(price), BSP_FIELD(symbol),
+                   BSP_FIELD(buy), BSP_FIELD(venue), BSP_FIELD(legs), BSP_FIELD(fills))
+);
+
+// ============================================================================
+// 带字段编号的结构体（Tagged），新版本调整了字段顺序、删除并新增了字段
+// ============================================================================
+
+struct Quote {
+    uint32_t id;
+    double price;
+    std::string symbol;
+    int64_t size;
+};
+
+BSP_SCHEMA_SET(Quote,
+               BSP_SCHEMA(BSP_FIELD_ID(id, 1), BSP_FIELD_ID(price, 2), BSP_FIELD_ID(symbol, 3),
+                   BSP_FIELD_ID_P(size, 4, bsp::proto::Varint))
+);
+
+struct QuoteNext {
+    std::string symbol;
+    uint32_t id;
+    std::vector<std::string> venues;
+    int64_t size;
+    Pixel color;
+    bool firm;
+};
+
+BSP_SCHEMA_SET(QuoteNext,
+               BSP_SCHEMA(BSP_FIELD_ID(symbol, 3), BSP_FIELD_ID(id, 1), BSP_FIELD_ID(venues, 5),
+                   BSP_FIELD_ID_P(size, 4, bsp::proto::Varint), BSP_FIELD_ID(color, 6), BSP_FIELD_ID(firm, 7))
+);
+
+// 多层嵌套的 Tagged / Versioned 结构体，最内层的值记录被编码的次数
+class CountingCVal : public bsp::types::CVal {
+public:
+    static inline size_t writes = 0;
+    uint8_t v = 0;
+
+    void write(bsp::io::AnyWriter &w, bsp::context &ctx) const override {
+        ++writes;
+        bsp::write(w, v, ctx);
+    }
+
+    void read(bsp::io::AnyReader &r, bsp::context &ctx) override {
+        bsp::read(r, v, ctx);
+    }
+};
+
+struct DeepLeaf {
+    CountingCVal c;
+};
+
+BSP_SCHEMA_SET(DeepLeaf,
+               BSP_SCHEMA(BSP_FIELD_ID(c, 1))
+);
+
+struct DeepMid {
+    DeepLeaf leaf;
+};
+
+BSP_SCHEMA_SET(DeepMid,
+               BSP_SCHEMA(BSP_FIELD_ID_P(leaf, 1, bsp::proto::Tagged<>))
+);
+
+struct DeepTop {
+    DeepMid mid;
+};
+
+BSP_SCHEMA_SET(DeepTop,
+               BSP_SCHEMA(BSP_FIELD_ID_P(mid, 1, bsp::proto::Versioned<true>))
+);
+
+// ============================================================================
+// 嵌套结构体（字段投影）
+// ============================================================================
+
+struct Fill {
+    Person trader;
+    Order order;
+    std::map<std::string, int> meta;
+    int32_t qty;
+};
+
+BSP_SCHEMA_SET(Fill,
+               BSP_SCHEMA(BSP_FIELD(trader), BSP_FIELD(order), BSP_FIELD(meta), BSP_FIELD(qty))
+);
+
+// ============================================================================
+// 共享缓冲区的切片字段
+// ============================================================================
+
+struct Frame {
+    uint32_t id;
+    bsp::types::slice payload;
+};
+
+BSP_SCHEMA_SET(Frame,
+               BSP_SCHEMA(BSP_FIELD(id), BSP_FIELD(payload))
+);
+
 // ============================================================================
 // 测试用的 CVal 派生类
 // ============================================================================
@@ -73,6 +248,19 @@ public:
     }
 };
 
+class FlagCVal : public bsp::types::CVal {
+public:
+    bool flag = false;
+
+    void write(bsp::io::AnyWriter &w, bsp::context &ctx) const override {
+        bsp::write(w, flag, ctx);
+    }
+
+    void read(bsp::io::AnyReader &r, bsp::context &ctx) override {
+        bsp::read(r, flag, ctx);
+    }
+};
+
 // ============================================================================
 // 辅助函数：检查两个 vector 是否相等
 // ============================================================================
@@ -443,12 +631,1737 @@ int main() {
             assert(false); // 不应该到达这里
         } catch (const errors::error &e) {
             std::cout << "  Caught expected error: " << e.what() << std::endl;
-            std::cout << e.format_tb() << std::endl;
         }
 
         std::cout << "  Error policy and traceback passed\n";
     }
 
+    // ------------------------------------------------------------------------
+    // 12. memcpy 快速路径 (内存布局与线格式一致的 Schema)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 12] memcpy fast path for layout-identical schemas\n";
+
+        static_assert(detail::memcpy_layout<Pixel, proto::Default>::value);
+        static_assert(detail::memcpy_layout<Sample, proto::Default>::value);
+        static_assert(!detail::memcpy_layout<Swapped, proto::Default>::value);
+        static_assert(!detail::memcpy_layout<Padded, proto::Default>::value);
+        static_assert(!detail::memcpy_layout<Person, proto::Default>::value);
+
+        std::vector<Pixel> pixels = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+        std::vector<Sample> samples = {{1, 0.5f}, {-2, 1.5f}};
+
+        BufferWriter bw;
+        write(bw, pixels);
+        write(bw, samples);
+
+        // [Varint 3][4 bytes each], then [Varint 2][memory of Sample each]
+        assert(bw.buf.size() == 1 + 3 * sizeof(Pixel) + 1 + 2 * sizeof(Sample));
+        assert(std::memcmp(bw.buf.data() + 1, pixels.data(), 3 * sizeof(Pixel)) == 0);
+        assert(std::memcmp(bw.buf.data() + 2 + 3 * sizeof(Pixel), samples.data(), 2 * sizeof(Sample)) == 0);
+
+        // Field order differing from memory order still goes field by field
+        BufferWriter bw2;
+        write(bw2, Swapped{1, 2});
+        assert(bw2.buf == (bytes{2, 1}));
+
+        BytesReader br(bw.buf);
+        std::vector<Pixel> pixels_out;
+        std::vector<Sample> samples_out;
+        read(br, pixels_out);
+        read(br, samples_out);
+
+        assert(pixels_out.size() == 3 && pixels_out[2].b == 11 && pixels_out[1].a == 8);
+        assert(samples_out.size() == 2 && samples_out[1].id == -2 && samples_out[1].value == 1.5f);
+
+        std::cout << "  memcpy fast path passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 13. 定长字段段 (一次边界检查)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 13] Coalesced runs of fixed-width fields\n";
+
+        static_assert(detail::fixed_run_end<Order, 0, 0>() == 3);
+        static_assert(detail::fixed_run_end<Order, 0, 4>() == 7);
+        static_assert(detail::fixed_run_size<Order, 0, 4, 7>() == 1 + 2 + 6);
+
+        Order order{42, -7, 101.25, "BSP", true, 9, {1, -2, 3}, {10, 20, 30}};
+
+        // Same bytes as writing each field on its own
+        BufferWriter expected;
+        write(expected, order.id);
+        write(expected, order.qty);
+        write(expected, order.price);
+        write(expected, order.symbol);
+        write(expected, order.buy);
+        write(expected, order.venue);
+        write(expected, order.legs);
+        write(expected, order.fills);
+
+        BufferWriter bw;
+        write(bw, order);
+        assert(bw.buf == expected.buf);
+
+        std::stringstream ss;
+        StreamWriter sw(ss);
+        write(sw, order);
+        assert(ss.str() == std::string(expected.buf.begin(), expected.buf.end()));
+
+        auto check = [&](const Order &o) {
+            return o.id == order.id && o.qty == order.qty && o.price == order.price && o.symbol == order.symbol &&
+                   o.buy == order.buy && o.venue == order.venue && o.legs == order.legs && o.fills == order.fills;
+        };
+
+        BytesReader br(bw.buf);
+        assert(check(read<Order>(br)));
+
+        StreamReader sr(ss);
+        assert(check(read<Order>(sr)));
+
+        BytesReader base(bw.buf);
+        LimitedReader limited(base, bw.buf.size());
+        assert(check(read<Order>(limited)));
+
+        // Truncated input fails at the run's single bounds check
+        BytesReader truncated(bw.buf.data(), 10);
+        try {
+            (void) read<Order>(truncated);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+
+        // Invalid bool inside a run is still rejected under STRICT
+        bytes corrupted = bw.buf;
+        corrupted[8 + 4 + 8 + 1 + 3] = 2;
+        context strict = context::get_default_context();
+        strict.sf.policy = errors::error_policy::STRICT;
+        BytesReader cr(corrupted);
+        try {
+            Order o;
+            read(cr, o, strict);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_bool);
+            assert(e.format_tb().find("Field \"buy\"") != std::string::npos);
+        }
+
+        // Elements wider than a stack run are staged on the heap for streams
+        using Wide = std::array<uint32_t, 1 << 21>;
+        std::vector<Wide> wide(1);
+        wide[0].fill(0x01020304);
+        wide[0].back() = 7;
+        std::stringstream wide_ss;
+        StreamWriter wide_w(wide_ss);
+        write(wide_w, wide);
+        StreamReader wide_r(wide_ss);
+        const auto wide_back = read<std::vector<Wide> >(wide_r);
+        assert(wide_back.size() == 1 && wide_back[0] == wide[0]);
+
+        std::cout << "  Coalesced fixed-width runs passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 14. 自描述版本头 (Versioned)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 14] Versioned envelopes\n";
+
+        Person p{"Bob", 41, true, "bob@example.com", {1, 2, 3}};
+
+        // Newer writer (V2) -> older reader (V1 only): trailing fields are skipped
+        BufferWriter bw;
+        write<proto::Versioned<> >(bw, p);
+        write(bw, uint8_t{0xAB});
+        assert(bw.buf[0] == 2);
+
+        BytesReader br(bw.buf);
+        auto old_reader = read<PersonV1, proto::Versioned<> >(br);
+        assert(old_reader.name == "Bob" && old_reader.age == 41 && old_reader.active);
+        assert(read<uint8_t>(br) == 0xAB);
+
+        // Older writer (V1) -> newer reader (V1, V2): new fields keep their defaults
+        BufferWriter bw2;
+        write<proto::Versioned<> >(bw2, PersonV1{"Ann", 29, false});
+        BytesReader br2(bw2.buf);
+        auto new_reader = read<Person, proto::Versioned<> >(br2);
+        assert(new_reader.name == "Ann" && new_reader.age == 29 && !new_reader.email && new_reader.scores.empty());
+
+        // The writer's version comes from the context
+        context ctx = context::get_default_context();
+        ctx.opt.target_schema_version = 1;
+        BufferWriter bw3;
+        write<proto::Versioned<false> >(bw3, p, ctx);
+        assert(bw3.buf[0] == 1);
+        BytesReader br3(bw3.buf);
+        auto unsized = read<Person, proto::Versioned<false> >(br3);
+        assert(unsized.name == "Bob" && !unsized.email);
+
+        // Without a length, unknown newer versions cannot be skipped
+        BufferWriter bw4;
+        write<proto::Versioned<false> >(bw4, p);
+        BytesReader br4(bw4.buf);
+        try {
+            (void) read<PersonV1, proto::Versioned<false> >(br4);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_index);
+        }
+
+        std::cout << "  Versioned envelopes passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 15. 跳转表分派 (variant / DynSchema)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 15] Jump-table dispatch\n";
+
+        static_assert(bsp::schema::match_schema_index<Person>(0) == SIZE_MAX);
+        static_assert(bsp::schema::match_schema_index<Person>(1) == 0);
+        static_assert(bsp::schema::match_schema_index<Person>(2) == 1);
+        static_assert(bsp::schema::match_schema_index<Person>(99) == 1);
+
+        // Every alternative goes through its own table slot
+        using V = std::variant<int8_t, uint16_t, std::string, double, std::vector<int>, bool>;
+        for (const V &v: {V{int8_t{-3}}, V{uint16_t{700}}, V{std::string("jmp")},
+                          V{2.5}, V{std::vector<int>{4, 5}}, V{true}}) {
+            BufferWriter bw;
+            write(bw, v);
+            BytesReader br(bw.buf);
+            assert(read<V>(br) == v);
+        }
+
+        BufferWriter bad_variant;
+        write(bad_variant, types::PVal<size_t, proto::Varint>{6});
+        BytesReader bad_br(bad_variant.buf);
+        try {
+            (void) read<V>(bad_br);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_index);
+        }
+
+        // DynSchema picks the newest version not above the target
+        Person p{"Eve", 22, true, "eve@example.com", {7}};
+        context ctx = context::get_default_context();
+        ctx.opt.target_schema_version = 99;
+        BufferWriter dyn, fixed;
+        write<proto::DynSchema>(dyn, p, ctx);
+        write<proto::Schema<2> >(fixed, p);
+        assert(dyn.buf == fixed.buf);
+
+        ctx.opt.target_schema_version = 0;
+        try {
+            write<proto::DynSchema>(dyn, p, ctx);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_index);
+        }
+
+        std::cout << "  Jump-table dispatch passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 16. 带字段编号的编码 (Tagged)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 16] Tagged fields\n";
+
+        Quote q{7, 101.25, "ACME", -1200};
+        BufferWriter bw;
+        write<proto::Tagged<> >(bw, q);
+        assert(bw.buf[0] == (1 << 3 | 3));  // id 1, fixed32
+        assert(bw.buf.back() == 0);         // end tag
+
+        BytesReader br(bw.buf);
+        auto q2 = read<Quote, proto::Tagged<> >(br);
+        assert(q2.id == 7 && q2.price == 101.25 && q2.symbol == "ACME" && q2.size == -1200);
+
+        // Newer writer: fields reordered, `price` removed, unknown fields skipped by the older reader
+        QuoteNext n{"XYZ", 9, {"NYSE", "ARCA"}, 300, {1, 2, 3, 4}, true};
+        BufferWriter bw2;
+        write<proto::Tagged<> >(bw2, n);
+        write(bw2, uint8_t{0xCD});
+
+        std::istringstream iss(std::string(bw2.buf.begin(), bw2.buf.end()));
+        StreamReader sr(iss);
+        auto old_q = read<Quote, proto::Tagged<> >(sr);
+        assert(old_q.id == 9 && old_q.symbol == "XYZ" && old_q.size == 300 && old_q.price == 0);
+        assert(read<uint8_t>(sr) == 0xCD);
+
+        // Older writer: fields missing from the message keep their defaults
+        BytesReader br3(bw.buf);
+        auto new_q = read<QuoteNext, proto::Tagged<> >(br3);
+        assert(new_q.id == 7 && new_q.symbol == "ACME" && new_q.size == -1200 && new_q.venues.empty() && !new_q.firm);
+
+        // A known id with another wire type is a schema conflict
+        BufferWriter bad;
+        write(bad, types::PVal<size_t, proto::Varint>{1 << 3 | 5});
+        write(bad, std::string("oops"));
+        bad.write_byte(0);
+        BytesReader bad_br(bad.buf);
+        try {
+            (void) read<Quote, proto::Tagged<> >(bad_br);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_index);
+            assert(e.message.find("field \"id\"") != std::string::npos);
+            assert(e.format_tb().find("Quote, Tagged<MAX>") != std::string::npos);
+        }
+
+        // Nested sized values are counted once per enclosing level, not once per pre-pass of every level
+        DeepTop deep;
+        deep.mid.leaf.c.v = 42;
+        BufferWriter bw_deep;
+        write<proto::Tagged<> >(bw_deep, deep);
+        assert(CountingCVal::writes == 4);
+        BytesReader br_deep(bw_deep.buf);
+        assert((read<DeepTop, proto::Tagged<> >(br_deep).mid.leaf.c.v == 42 && br_deep.pos == bw_deep.buf.size()));
+
+        std::cout << "  Tagged fields passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 17. 字段投影 (read_fields)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 17] Field projection\n";
+
+        Order o{42, -7, 99.5, "ACME", true, 3, {1, -2, 3}, {10, 20, 30}};
+        BufferWriter bw;
+        write(bw, o);
+        write(bw, uint8_t{0xEE});
+
+        BytesReader br(bw.buf);
+        auto part = read_fields<Order, &Order::price, &Order::fills>(br);
+        assert(part.price == 99.5 && part.fills == o.fills);
+        assert(part.id == 0 && part.symbol.empty() && !part.buy && part.legs == (std::array<int16_t, 3>{}));
+        assert(read<uint8_t>(br) == 0xEE);  // Whole message consumed
+
+        // Nested schemas, optionals and maps are skipped on a stream as well
+        Fill f{{"Bob", 41, true, "bob@example.com", {1, 2}}, o, {{"k", 1}, {"v", 2}}, 250};
+        BufferWriter bw2;
+        write(bw2, f);
+        write(bw2, uint8_t{0xEF});
+        std::istringstream iss(std::string(bw2.buf.begin(), bw2.buf.end()));
+        StreamReader sr(iss);
+        auto qty_only = read_fields<Fill, &Fill::qty>(sr);
+        assert(qty_only.qty == 250 && qty_only.trader.name.empty() && qty_only.meta.empty());
+        assert(read<uint8_t>(sr) == 0xEF);
+
+        // Truncated data is still reported
+        BytesReader short_br(bw.buf.data(), 20);
+        try {
+            (void) read_fields<Order, &Order::fills>(short_br);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+
+        std::cout << "  Field projection passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 18. 惰性视图 (lazy)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 18] Lazy views\n";
+
+        Order o{42, -7, 99.5, "ACME", true, 3, {1, -2, 3}, {10, 20, 30}};
+        BufferWriter bw;
+        write(bw, o);
+        const size_t message_size = bw.buf.size();
+        write(bw, uint8_t{0xEE});  // Bytes after the message are not part of it
+
+        lazy<Order> view(bw.buf);
+        assert(view.get<&Order::buy>() == true);
+        assert(view.get<&Order::symbol>() == "ACME");
+        assert(view.get<&Order::id>() == 42);
+
+        // Raw field bytes can be forwarded or decoded independently
+        auto raw_symbol = view.raw<&Order::symbol>();
+        BytesReader sym_br(raw_symbol.data(), raw_symbol.size());
+        assert(read<std::string>(sym_br) == "ACME" && sym_br.pos == raw_symbol.size());
+
+        auto whole = view.bytes();
+        assert(whole.size() == message_size && whole.data() == bw.buf.data());
+
+        Order m = view.materialize();
+        assert(m.id == o.id && m.qty == o.qty && m.price == o.price && m.symbol == o.symbol && m.buy == o.buy &&
+            m.venue == o.venue && m.legs == o.legs && m.fills == o.fills);
+
+        // Fields past the end of the buffer report EOF when located
+        lazy<Order> truncated(bw.buf.data(), 20);
+        assert(truncated.get<&Order::qty>() == -7);
+        try {
+            (void) truncated.get<&Order::fills>();
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+
+        std::cout << "  Lazy views passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 19. 可随机访问的 vector (Indexed)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 19] Indexed vectors\n";
+
+        std::vector<std::string> words;
+        for (int i = 0; i < 1000; ++i)
+            words.push_back(std::string(static_cast<size_t>(i % 37), static_cast<char>('a' + i % 26)));
+
+        BufferWriter bw;
+        write<proto::Indexed<> >(bw, words);
+        write(bw, uint8_t{0xEE});
+
+        using Words = std::vector<std::string>;
+        BytesReader br(bw.buf);
+        assert((read<Words, proto::Indexed<> >(br) == words));
+        assert(read<uint8_t>(br) == 0xEE);
+
+        // Single elements and ranges are decoded without touching the rest
+        indexed_view<std::string> view(bw.buf);
+        assert(view.size() == words.size() && view.encoded_size() == bw.buf.size() - 1);
+        assert(view.at(999) == words[999] && view.at(0) == words[0] && view.at(500) == words[500]);
+        assert(view.range(10, 13) == std::vector<std::string>(words.begin() + 10, words.begin() + 13));
+        assert(view.raw(36).size() == 1 + 36);
+        try {
+            (void) view.at(1000);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_index);
+        }
+
+        // Elements with their own protocol
+        std::vector<Person> people{{"A", 1, true, std::nullopt, {}}, {"Bob", 41, false, "b@x", {1, 2, 3}}};
+        BufferWriter bw2;
+        write<proto::Indexed<proto::Schema<1> > >(bw2, people);
+        indexed_view<Person, proto::Schema<1> > pview(bw2.buf);
+        assert(pview.at(1).name == "Bob" && pview.at(1).age == 41 && !pview.at(1).email);
+
+        // Empty vectors carry no offset table
+        BufferWriter bw3;
+        write<proto::Indexed<> >(bw3, std::vector<int32_t>{});
+        assert(bw3.buf.size() == 2);
+        assert(indexed_view<int32_t>(bw3.buf).size() == 0);
+
+        // A corrupt offset table is detected by sequential STRICT reads
+        std::vector<uint8_t> corrupt = bw.buf;
+        corrupt[6] ^= 0xFF;  // Inside the offset table, after 2 + 3 header bytes
+        BytesReader cbr(corrupt);
+        context strict = context::get_default_context();
+        strict.sf.policy = errors::error_policy::STRICT;
+        try {
+            (void) read<proto::Indexed<>, Words>(cbr, strict);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::fixed_size_mismatch);
+        }
+
+        std::cout << "  Indexed vectors passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 20. 列式编码 (Columnar)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 20] Columnar vectors\n";
+
+        std::vector<Order> orders;
+        for (uint32_t i = 0; i < 300; ++i)
+            orders.push_back(Order{i, static_cast<int32_t>(i) - 150, i * 0.5, std::string(i % 5, 'x'), i % 3 == 0,
+                                   static_cast<uint16_t>(i * 7), {1, 2, static_cast<int16_t>(i)}, {i, i + 1}});
+
+        BufferWriter bw;
+        write<proto::Columnar<> >(bw, orders);
+
+        // The first column holds all ids
+        BytesReader header(bw.buf);
+        assert((read<size_t, proto::Varint>(header) == 300));
+        assert(read<uint64_t>(header) == 0 && read<uint64_t>(header) == 1);
+
+        auto check = [&](const std::vector<Order> &got) {
+            assert(got.size() == orders.size());
+            for (size_t i = 0; i < got.size(); ++i)
+                assert(got[i].id == orders[i].id && got[i].qty == orders[i].qty && got[i].price == orders[i].price &&
+                    got[i].symbol == orders[i].symbol && got[i].buy == orders[i].buy &&
+                    got[i].venue == orders[i].venue && got[i].legs == orders[i].legs &&
+                    got[i].fills == orders[i].fills);
+        };
+
+        BytesReader br(bw.buf);
+        check(read<std::vector<Order>, proto::Columnar<> >(br));
+
+        std::istringstream iss(std::string(bw.buf.begin(), bw.buf.end()));
+        StreamReader sr(iss);
+        check(read<std::vector<Order>, proto::Columnar<> >(sr));
+
+        // Struct-of-arrays holder with the same wire format
+        BytesReader br2(bw.buf);
+        auto cols = read<columns<Order> >(br2);
+        assert(cols.size() == 300 && cols.get<&Order::price>()[10] == 5.0 && cols.get<&Order::buy>()[3]);
+        assert(cols.row(42).symbol == orders[42].symbol);
+
+        BufferWriter bw2;
+        write(bw2, cols);
+        assert(bw2.buf == bw.buf);
+
+        // Columns of different lengths cannot be written
+        cols.get<&Order::venue>().pop_back();
+        BufferWriter bw3;
+        try {
+            write(bw3, cols);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::fixed_size_mismatch);
+        }
+
+        columns<Order> built;
+        for (const auto &o: orders) built.push_back(o);
+        BufferWriter bw4;
+        write(bw4, built);
+        assert(bw4.buf == bw.buf);
+
+        std::cout << "  Columnar vectors passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 21. 分块并行编码 (Chunked)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 21] Chunked containers\n";
+
+        std::vector<std::string> items;
+        for (int i = 0; i < 10000; ++i)
+            items.push_back(std::to_string(i * 7919));
+
+        parallel::thread_pool pool(4);
+        context seq = context::get_default_context();
+        seq.opt.chunk_size = 1000;
+        context par = seq;
+        par.opt.pool = &pool;
+
+        // Output does not depend on the pool
+        BufferWriter bw_seq, bw_par;
+        write<proto::Chunked<> >(bw_seq, items, seq);
+        write<proto::Chunked<> >(bw_par, items, par);
+        assert(bw_seq.buf == bw_par.buf);
+        write(bw_par, uint8_t{0xEE});
+
+        using Items = std::vector<std::string>;
+        BytesReader br(bw_par.buf);
+        assert((read<proto::Chunked<>, Items>(br, par) == items));
+        assert(read<uint8_t>(br) == 0xEE);
+
+        BytesReader br_seq(bw_par.buf);
+        assert((read<proto::Chunked<>, Items>(br_seq, seq) == items));
+
+        std::istringstream iss(std::string(bw_par.buf.begin(), bw_par.buf.end()));
+        StreamReader sr(iss);
+        assert((read<proto::Chunked<>, Items>(sr, par) == items));
+        assert(read<uint8_t>(sr) == 0xEE);
+
+        // Maps decode concurrently and insert on the calling thread
+        std::unordered_map<int, std::string> table;
+        for (int i = 0; i < 5000; ++i) table[i] = items[static_cast<size_t>(i)];
+        BufferWriter bw_map;
+        write<proto::Chunked<> >(bw_map, table, par);
+        BytesReader br_map(bw_map.buf);
+        assert((read<proto::Chunked<>, std::unordered_map<int, std::string> >(br_map, par) == table));
+
+        // Errors in a worker are rethrown with the chunk's traceback
+        context strict = par;
+        strict.sf.max_string_size = 3;
+        BytesReader br_err(bw_par.buf);
+        try {
+            (void) read<proto::Chunked<>, Items>(br_err, strict);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::string_too_large);
+            assert(e.format_tb().find("std::vector, Chunked") != std::string::npos);
+        }
+
+        // Chunk lengths that wrap around size_t are rejected before decoding
+        types::bytes wrapping = {0x02, 0x02};
+        wrapping.insert(wrapping.end(), 9, 0xFF);
+        wrapping.insert(wrapping.end(), {0x01, 0x00, 0x03, 0x00});
+        wrapping.resize(50, 0x00);
+        BytesReader br_wrap(wrapping);
+        try {
+            (void) read<proto::Chunked<>, Items>(br_wrap, seq);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::fixed_size_mismatch);
+        }
+        BytesReader br_try_wrap(wrapping);
+        assert((try_read<Items, proto::Chunked<> >(br_try_wrap, seq).error() == errors::code::fixed_size_mismatch));
+
+        // Forged chunk sizes fail at the end of the input instead of being allocated up front
+        types::bytes forged = {0x02, 0x02};
+        for (int c = 0; c < 2; ++c) forged.insert(forged.end(), {0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x20});
+        forged.resize(64, 0x00);
+        std::istringstream forged_iss(std::string(forged.begin(), forged.end()));
+        StreamReader sr_forged(forged_iss);
+        try {
+            (void) read<proto::Chunked<>, Items>(sr_forged, par);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+
+        // Contiguous readers that stage on demand are bounded as well
+        const std::array<std::span<const uint8_t>, 2> forged_parts{
+            std::span<const uint8_t>(forged).first(10), std::span<const uint8_t>(forged).subspan(10)
+        };
+        SegmentedReader seg_forged(forged_parts);
+        std::istringstream prefetch_iss(std::string(forged.begin(), forged.end()));
+        PrefetchReader prefetch_forged(prefetch_iss, {.buffers = 2, .buffer_size = 16});
+        auto expect_eof = [&](auto &reader) {
+            try {
+                (void) read<proto::Chunked<>, Items>(reader, par);
+                assert(false);
+            } catch (const errors::error &e) {
+                assert(e.c == errors::code::unexpected_eof);
+            }
+        };
+        expect_eof(seg_forged);
+        expect_eof(prefetch_forged);
+
+        std::cout << "  Chunked containers passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 22. 批量并行编码 (batch_encoder)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 22] Batch encoder\n";
+
+        std::vector<Order> orders;
+        for (int i = 0; i < 3000; ++i)
+            orders.push_back({
+                static_cast<uint64_t>(i), -i, i * 0.5, std::string(static_cast<size_t>(i % 17), 'S'), i % 2 == 0,
+                static_cast<uint16_t>(i), {1, -2, 3}, std::vector<uint32_t>(static_cast<size_t>(i % 5), 7u)
+            });
+
+        parallel::thread_pool pool(4);
+        parallel::batch_encoder<Order> encoder(pool);
+
+        // Messages keep input order and match single writes, buffers are reused between batches
+        for (int round = 0; round < 2; ++round) {
+            encoder.encode(orders);
+            assert(encoder.size() == orders.size());
+            for (size_t i = 0; i < orders.size(); i += 97) {
+                BufferWriter bw;
+                write(bw, orders[i]);
+                assert(encoder.message(i) == bw.buf);
+            }
+        }
+
+        // Framed output is a sequence of Limited<Varint>
+        const auto &framed = encoder.encode_framed(std::span(orders).first(500));
+        assert(encoder.size() == 500);
+        BytesReader br(framed);
+        for (size_t i = 0; i < 500; ++i) {
+            auto o = read<Order, proto::Limited<proto::Varint, proto::Default> >(br);
+            assert(o.id == i && o.symbol == orders[i].symbol && o.fills == orders[i].fills);
+        }
+        assert(br.pos == framed.size());
+
+        // The error of the lowest failing message is rethrown
+        std::vector<std::string> names;
+        for (size_t i = 0; i < 1000; ++i) names.emplace_back(i % 40, 'N');
+        parallel::batch_encoder<std::string, proto::Limited<proto::Fixed<16>, proto::Default> > limited(pool);
+        try {
+            limited.encode(names);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::fixed_size_mismatch);
+            assert(e.message.find("fixed size 17") != std::string::npos);
+        }
+
+        std::cout << "  Batch encoder passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 23. 批量读写 (write_batch / read_batch)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 23] Batch read/write\n";
+
+        std::vector<Order> orders;
+        for (int i = 0; i < 100; ++i)
+            orders.push_back({static_cast<uint64_t>(i), i, i * 1.5, std::to_string(i), i % 3 == 0, 7, {}, {1, 2}});
+
+        // Same bytes as one write per value
+        BufferWriter each, batch;
+        for (const auto &o: orders) write(each, o);
+        write_batch(batch, orders);
+        assert(each.buf == batch.buf);
+
+        context ctx = context::get_default_context();
+        BytesReader br(batch.buf);
+        auto loaded = read_batch<Order>(br, orders.size(), ctx);
+        assert(br.pos == batch.buf.size());
+        for (size_t i = 0; i < orders.size(); ++i)
+            assert(loaded[i].id == i && loaded[i].symbol == orders[i].symbol && loaded[i].fills == orders[i].fills);
+
+        // Fixed-width values take the bulk path, any range works
+        std::vector<int32_t> ints{1, -2, 3, -4};
+        BufferWriter bw_ints;
+        write_batch<proto::Fixed<> >(bw_ints, ints);
+        write_batch(bw_ints, std::set<std::string>{"a", "b"});
+        assert(bw_ints.buf.size() == 16 + 4);
+        std::array<int32_t, 4> ints_back{};
+        std::vector<std::string> strs_back(2);
+        BytesReader br_ints(bw_ints.buf);
+        read_batch<proto::Fixed<> >(br_ints, ints_back);
+        read_batch(br_ints, strs_back);
+        assert(ints_back[1] == -2 && ints_back[3] == -4);
+        assert(strs_back[0] == "a" && strs_back[1] == "b");
+
+        // Errors name the failing index
+        BytesReader br_short(batch.buf.data(), batch.buf.size() / 2);
+        try {
+            (void) read_batch<Order>(br_short, orders.size(), ctx);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+        context strict = context::get_default_context();
+        strict.sf.max_string_size = 1;
+        BytesReader br_limit(batch.buf);
+        try {
+            (void) read_batch<Order>(br_limit, orders.size(), strict);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::string_too_large);
+            assert(e.format_tb().find("batch index=10") != std::string::npos);
+        }
+
+        // The runtime error policy is resolved once and still applies to every value
+        const types::bytes flags{1, 2};
+        std::deque<bool> flags_back(2);
+        BytesReader br_medium(flags);
+        read_batch(br_medium, flags_back, ctx);
+        assert(flags_back[0] && flags_back[1]);
+        strict.sf.policy = errors::error_policy::STRICT;
+        BytesReader br_strict(flags);
+        try {
+            read_batch(br_strict, flags_back, strict);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_bool);
+            assert(e.format_tb().find("batch index=1") != std::string::npos);
+        }
+        assert(strict.st.current_depth == 0);
+
+        std::cout << "  Batch read/write passed\n";
+    }
+
+#ifdef BSP_POSIX
+    // ------------------------------------------------------------------------
+    // 24. 并发追加的记录日志 (RecordLog)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 24] Record log\n";
+
+        const auto path = (std::filesystem::temp_directory_path() /
+                           ("bsp_record_log_" + std::to_string(::getpid()))).string();
+        std::filesystem::remove(path);
+
+        {
+            RecordLog log(path, 1 << 20);
+            RecordLogReader tail(path);
+            assert(!tail.next());
+
+            // Concurrent writers, each record lands whole
+            std::vector<std::thread> writers;
+            for (uint32_t t = 0; t < 4; ++t)
+                writers.emplace_back([&log, t] {
+                    for (uint32_t i = 0; i < 500; ++i) {
+                        log.append(std::make_pair(t, std::string(i % 23, static_cast<char>('a' + t))));
+                        if (i % 100 == 0) log.sync();
+                    }
+                });
+            for (auto &w: writers) w.join();
+            log.sync();
+
+            std::array<uint32_t, 4> seen{};
+            std::pair<uint32_t, std::string> rec;
+            while (tail.next(rec)) {
+                assert(rec.second == std::string(seen[rec.first] % 23, static_cast<char>('a' + rec.first)));
+                ++seen[rec.first];
+            }
+            assert((seen == std::array<uint32_t, 4>{500, 500, 500, 500}));
+            assert(tail.skipped() == 0);
+
+            // The tailing reader picks up new records
+            const uint64_t last = log.append(std::string("tail"));
+            std::string s;
+            assert(tail.next(s) && s == "tail");
+            assert(!tail.next());
+
+            // Full logs refuse records
+            RecordLog small(path + ".small", 64);
+            small.append(std::string(40, 'x'));
+            try {
+                small.append(std::string(40, 'y'));
+                assert(false);
+            } catch (const errors::error &e) {
+                assert(e.c == errors::code::runtime_error);
+            }
+            std::filesystem::remove(path + ".small");
+
+            // Torn record: a damaged payload fails the CRC and is skipped
+            log.append(std::string("torn"));
+            log.append(std::string("after"));
+            {
+                std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+                // Header, the 24-byte "tail" record, then into the payload of "torn"
+                f.seekp(static_cast<std::streamoff>(64 + last + 24 + 16 + 2));
+                f.put('X');
+            }
+            assert(tail.next(s) && s == "after");
+            assert(tail.skipped() == 1);
+
+            // Pending record (writer died before committing): stops the tail, skipped in recovery
+            const uint64_t pending = log.append(std::string("lost"));
+            log.append(std::string("kept"));
+            {
+                std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+                f.seekp(static_cast<std::streamoff>(64 + pending + 8));
+                const uint32_t zero = 0;
+                f.write(reinterpret_cast<const char *>(&zero), sizeof(zero));
+            }
+            assert(!tail.next());
+
+            // Writer died between reserving and storing the size: recovery scans past the hole
+            {
+                std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+                uint64_t reserved = 0;
+                f.seekg(16);
+                f.read(reinterpret_cast<char *>(&reserved), sizeof(reserved));
+                reserved += 32;
+                f.seekp(16);
+                f.write(reinterpret_cast<const char *>(&reserved), sizeof(reserved));
+            }
+            log.append(std::string("found"));
+
+            RecordLogReader recovered(path, true);
+            size_t count = 0;
+            std::span<const uint8_t> last_rec;
+            while (const auto rec = recovered.next()) {
+                last_rec = *rec;
+                ++count;
+            }
+            assert(count == 2000 + 4);
+            assert(recovered.skipped() == 3);
+            BytesReader found_r(last_rec.data(), last_rec.size());
+            assert(read<std::string>(found_r) == "found");
+        }
+
+        // Reopening continues after the existing records
+        {
+            RecordLog log(path, 0);
+            assert(log.size() > 0);
+            log.append(std::string("reopened"));
+            RecordLogReader r(path, true);
+            std::string s;
+            while (r.next(s)) {
+            }
+            assert(s == "reopened");
+        }
+        std::filesystem::remove(path);
+
+        std::cout << "  Record log passed\n";
+    }
+#endif
+
+    // ------------------------------------------------------------------------
+    // 25. 双缓冲异步写入 (AsyncWriter)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 25] Async writer\n";
+
+        std::vector<Order> orders;
+        for (int i = 0; i < 500; ++i)
+            orders.push_back({static_cast<uint64_t>(i), i, i * 0.5, std::string(static_cast<size_t>(i % 40), 'Q'), true, 1, {}, {}});
+        std::vector<int32_t> block(1000, -5);
+
+        BufferWriter expected;
+        write_batch(expected, orders);
+        write_batch<proto::Fixed<> >(expected, block);
+
+        // Tiny buffers force hand-offs, back-pressure and an oversized reservation
+        std::ostringstream oss;
+        {
+            AsyncWriter aw(oss, {.buffers = 3, .buffer_size = 256});
+            write_batch(aw, orders);
+            write_batch<proto::Fixed<> >(aw, block);
+            aw.flush();
+            assert(oss.str().size() == expected.buf.size());
+            aw.close();
+
+            // Writes after close() are refused, even ones that would fit in the current buffer
+            try {
+                write(aw, uint8_t{1});
+                assert(false);
+            } catch (const errors::error &e) {
+                assert(e.c == errors::code::runtime_error);
+            }
+            try {
+                write(aw, std::string("late"));
+                assert(false);
+            } catch (const errors::error &e) {
+                assert(e.c == errors::code::runtime_error);
+            }
+        }
+        assert(oss.str() == std::string(expected.buf.begin(), expected.buf.end()));
+
+#ifdef BSP_POSIX
+        const auto path = (std::filesystem::temp_directory_path() /
+                           ("bsp_async_" + std::to_string(::getpid()))).string();
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        assert(fd >= 0);
+        {
+            AsyncWriter aw(fd, {.buffers = 2, .buffer_size = 1000});
+            write_batch(aw, orders);
+            write_batch<proto::Fixed<> >(aw, block);
+        }
+        ::close(fd);
+        std::ifstream in(path, std::ios::binary);
+        const std::string from_fd((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        assert(from_fd == std::string(expected.buf.begin(), expected.buf.end()));
+        std::filesystem::remove(path);
+#endif
+
+        // Deferred I/O errors surface on a later hand-off or flush
+        std::ostream broken(nullptr);
+        AsyncWriter bad(broken, {.buffers = 2, .buffer_size = 64});
+        try {
+            write_batch(bad, orders);
+            bad.flush();
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::runtime_error);
+        }
+        try {
+            bad.close();
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::runtime_error);
+        }
+
+        std::cout << "  Async writer passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 26. 后台预读 (PrefetchReader)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 26] Prefetch reader\n";
+
+        std::vector<Order> orders;
+        for (int i = 0; i < 500; ++i)
+            orders.push_back({static_cast<uint64_t>(i), i, i * 0.5, std::string(static_cast<size_t>(i % 40), 'P'), true, 1, {}, {}});
+        std::vector<int32_t> block(1000, -5);
+
+        BufferWriter encoded;
+        write_batch(encoded, orders);
+        write_batch<proto::Fixed<> >(encoded, block);
+        const std::string bytes(encoded.buf.begin(), encoded.buf.end());
+
+        auto check = [&](auto &reader) {
+            context ctx = context::get_default_context();
+            const auto loaded = read_batch<Order>(reader, orders.size(), ctx);
+            for (size_t i = 0; i < orders.size(); i += 37)
+                assert(loaded[i].id == i && loaded[i].symbol == orders[i].symbol);
+            std::vector<int32_t> back(block.size());
+            read_batch<proto::Fixed<> >(reader, back, ctx);
+            assert(back == block);
+            try {
+                (void) reader.read_byte();
+                assert(false);
+            } catch (const errors::error &e) {
+                assert(e.c == errors::code::unexpected_eof);
+            }
+        };
+
+        // Tiny buffers: values cross buffer boundaries, the fixed block is staged
+        std::istringstream iss(bytes);
+        PrefetchReader pr(iss, {.buffers = 3, .buffer_size = 100});
+        check(pr);
+
+#ifdef BSP_POSIX
+        const auto path = (std::filesystem::temp_directory_path() /
+                           ("bsp_prefetch_" + std::to_string(::getpid()))).string();
+        std::ofstream(path, std::ios::binary) << bytes;
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        assert(fd >= 0);
+        {
+            PrefetchReader fr(fd, {.buffers = 2, .buffer_size = 4096});
+            check(fr);
+        }
+        ::close(fd);
+        std::filesystem::remove(path);
+#endif
+
+        // Source errors are rethrown on the decoding thread
+        std::istream broken(nullptr);
+        PrefetchReader bad(broken);
+        try {
+            (void) bad.read_byte();
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::runtime_error);
+        }
+
+        // Unknown and projected fields are skipped block by block, a forged borrow ends at EOF
+        QuoteNext next{"SKIP", 4, std::vector<std::string>(50, std::string(300, 's')), 8, {}, false};
+        BufferWriter bw_next;
+        write<proto::Tagged<> >(bw_next, next);
+        std::istringstream next_iss(std::string(bw_next.buf.begin(), bw_next.buf.end()));
+        PrefetchReader next_r(next_iss, {.buffers = 2, .buffer_size = 128});
+        const auto q = read<Quote, proto::Tagged<> >(next_r);
+        assert(q.id == 4 && q.symbol == "SKIP" && q.size == 8);
+
+        std::istringstream short_iss(bytes.substr(0, 1000));
+        PrefetchReader short_r(short_iss, {.buffers = 2, .buffer_size = 128});
+        try {
+            (void) short_r.borrow_bytes(size_t{1} << 40);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+
+        std::cout << "  Prefetch reader passed\n";
+    }
+
+#ifdef BSP_POSIX
+    // ------------------------------------------------------------------------
+    // 27. 共享内存环形缓冲区 (ShmRingWriter / ShmRingReader)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 27] Shared-memory ring\n";
+
+        const auto dir = std::filesystem::exists("/dev/shm") ? std::filesystem::path("/dev/shm")
+                                                               : std::filesystem::temp_directory_path();
+        const auto path = (dir / ("bsp_ring_" + std::to_string(::getpid()))).string();
+
+        // Single producer: variable sizes wrap around a small ring many times
+        create_shm_ring(path, 4096);
+        {
+            std::thread producer([&] {
+                ShmRingWriter w(path);
+                for (uint32_t i = 0; i < 20000; ++i)
+                    w.send(std::make_pair(i, std::string(i % 300, 'r')));
+            });
+            ShmRingReader r(path);
+            for (uint32_t i = 0; i < 20000; ++i) {
+                const auto m = r.receive<std::pair<uint32_t, std::string> >();
+                assert(m.first == i && m.second.size() == i % 300);
+            }
+            producer.join();
+            assert(!r.try_next());
+
+            // io::Writer / io::Reader over single messages
+            ShmRingWriter w(path);
+            write(w, std::string("hello"));
+            write(w, 42);
+            w.commit();
+            r.next();
+            assert(read<std::string>(r) == "hello");
+            assert(read<int>(r) == 42);
+            assert(r.remaining() == 0);
+            try {
+                (void) read<int>(r);
+                assert(false);
+            } catch (const errors::error &e) {
+                assert(e.c == errors::code::unexpected_eof);
+            }
+
+            try {
+                w.send(std::string(w.max_message_size(), 'x'));
+                assert(false);
+            } catch (const errors::error &e) {
+                assert(e.c == errors::code::fixed_size_mismatch);
+            }
+        }
+
+        // Multiple producers: each producer's messages arrive in order
+        create_shm_ring(path, 8192, true);
+        {
+            std::vector<std::thread> producers;
+            for (uint32_t t = 0; t < 3; ++t)
+                producers.emplace_back([&, t] {
+                    ShmRingWriter w(path);
+                    for (uint32_t i = 0; i < 5000; ++i)
+                        w.send(std::make_tuple(t, i, std::string(i % 50, 'm')));
+                });
+            ShmRingReader r(path);
+            std::array<uint32_t, 3> seen{};
+            for (int i = 0; i < 15000; ++i) {
+                const auto [t, seq, text] = r.receive<std::tuple<uint32_t, uint32_t, std::string> >();
+                assert(seq == seen[t] && text.size() == seq % 50);
+                ++seen[t];
+            }
+            for (auto &p: producers) p.join();
+        }
+        std::filesystem::remove(path);
+
+        std::cout << "  Shared-memory ring passed\n";
+    }
+#endif
+
+#ifdef BSP_POSIX
+    // ------------------------------------------------------------------------
+    // 28. 文件描述符读写 (FdReader / FdWriter)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 28] File descriptor I/O\n";
+
+        int sv[2];
+        assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+        std::vector<Order> orders;
+        for (int i = 0; i < 2000; ++i)
+            orders.push_back({static_cast<uint64_t>(i), i, i * 0.5, std::string(static_cast<size_t>(i % 40), 'F'), true, 1, {}, {}});
+        types::bytes blob(3 * 1024 * 1024);
+        for (size_t i = 0; i < blob.size(); ++i) blob[i] = static_cast<uint8_t>(i * 31);
+        const std::string header = "header";
+
+        // Small values are buffered, the blob leaves with the buffered bytes in one writev
+        std::thread sender([&] {
+            {
+                FdWriter w(sv[0], 4096);
+                write_batch(w, orders);
+                write(w, blob);
+                write(w, header);
+                const std::array<std::span<const uint8_t>, 2> parts{
+                    std::span<const uint8_t>(blob).first(1000), std::span<const uint8_t>(blob).last(1000)
+                };
+                w.write_vectored(parts);
+                write_batch<proto::Fixed<> >(w, std::vector<int32_t>(5000, 9));
+            }
+            ::shutdown(sv[0], SHUT_WR);
+        });
+
+        FdReader r(sv[1], 4096);
+        context ctx = context::get_default_context();
+        const auto loaded = read_batch<Order>(r, orders.size(), ctx);
+        for (size_t i = 0; i < orders.size(); i += 41)
+            assert(loaded[i].id == i && loaded[i].symbol == orders[i].symbol);
+        assert(read<types::bytes>(r) == blob);
+        assert(read<std::string>(r) == header);
+        types::bytes raw(2000);
+        r.read_bytes(raw.data(), 2000);
+        assert(std::equal(raw.begin(), raw.begin() + 1000, blob.begin()));
+        assert(std::equal(raw.begin() + 1000, raw.end(), blob.end() - 1000));
+        std::vector<int32_t> ints(5000);
+        read_batch<proto::Fixed<> >(r, ints, ctx);
+        assert(ints == std::vector<int32_t>(5000, 9));
+        sender.join();
+
+        try {
+            (void) r.read_byte();
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+        ::close(sv[0]);
+        ::close(sv[1]);
+
+        // Unknown fields are skipped in buffer-sized steps, a forged length ends at EOF without a huge buffer
+        auto feed = [](const types::bytes &bytes, auto &&consume) {
+            int fds[2];
+            assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+            std::thread feeder([&] {
+                {
+                    FdWriter w(fds[0]);
+                    w.write_bytes(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+                }
+                ::shutdown(fds[0], SHUT_WR);
+            });
+            FdReader fr(fds[1], 4096);
+            consume(fr);
+            feeder.join();
+            ::close(fds[0]);
+            ::close(fds[1]);
+        };
+
+        QuoteNext next{"WIDE", 3, std::vector<std::string>(100, std::string(1000, 'v')), 12, {}, true};
+        BufferWriter bw_next;
+        write<proto::Tagged<> >(bw_next, next);
+        feed(bw_next.buf, [](FdReader &fr) {
+            const auto q = read<Quote, proto::Tagged<> >(fr);
+            assert(q.id == 3 && q.symbol == "WIDE" && q.size == 12);
+        });
+
+        BufferWriter forged;
+        write(forged, types::PVal<size_t, proto::Varint>{9 << 3 | static_cast<size_t>(detail::wire_type::length)});
+        write(forged, types::PVal<size_t, proto::Varint>{size_t{1} << 36});
+        write(forged, std::string("short"));
+        feed(forged.buf, [](FdReader &fr) {
+            try {
+                (void) read<Quote, proto::Tagged<> >(fr);
+                assert(false);
+            } catch (const errors::error &e) {
+                assert(e.c == errors::code::unexpected_eof);
+            }
+        });
+
+        std::cout << "  File descriptor I/O passed\n";
+    }
+#endif
+
+    // ------------------------------------------------------------------------
+    // 29. 借用大负载的分散写入 (ScatterWriter)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 29] Scatter writer\n";
+
+        Data d{7, types::bytes(20000)};
+        for (size_t i = 0; i < d.payload.size(); ++i) d.payload[i] = static_cast<uint8_t>(i);
+        const std::string note(100, 'n');
+        const std::vector<int32_t> samples(3000, 4);
+
+        BufferWriter expected;
+        write(expected, d);
+        write(expected, note);
+        write<proto::Trivial>(expected, samples);
+
+        ScatterWriter sw;
+        write(sw, d);
+        write(sw, note);
+        write<proto::Trivial>(sw, samples);
+
+        // Large payloads are referenced in place, small data is coalesced around them
+        const auto &segs = sw.segments();
+        assert(segs.size() == 4);
+        assert(segs[1].data() == d.payload.data() && segs[1].size() == d.payload.size());
+        assert(segs[3].data() == reinterpret_cast<const uint8_t *>(samples.data()));
+        assert(sw.size() == expected.buf.size());
+
+        BufferWriter copied;
+        sw.copy_to(copied);
+        assert(copied.buf == expected.buf);
+
+        // Payloads inside a temporary buffer are copied, never borrowed
+        sw.clear();
+        write<proto::Limited<proto::Varint, proto::Default> >(sw, d);
+        for (const auto &seg: sw.segments())
+            assert(seg.data() < d.payload.data() || seg.data() >= d.payload.data() + d.payload.size());
+
+#ifdef BSP_POSIX
+        // Zero-copy send: owned chunks and borrowed payloads in one writev
+        sw.clear();
+        write(sw, d);
+        write(sw, note);
+        int sv[2];
+        assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+        std::thread sender([&] {
+            FdWriter w(sv[0]);
+            w.write_vectored(sw.segments());
+        });
+        FdReader r(sv[1]);
+        const auto back = read<Data>(r);
+        assert(back.id == 7 && back.payload == d.payload);
+        assert(read<std::string>(r) == note);
+        sender.join();
+        ::close(sv[0]);
+        ::close(sv[1]);
+#endif
+
+        std::cout << "  Scatter writer passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 30. 分段输入读取 (SegmentedReader)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 30] Segmented reader\n";
+
+        std::vector<Order> orders;
+        for (int i = 0; i < 200; ++i)
+            orders.push_back({static_cast<uint64_t>(i), i, i * 0.5, std::string(static_cast<size_t>(i % 40), 'G'), true, 1, {1, 2, 3}, {7, 8}});
+        BufferWriter bw;
+        write_batch(bw, orders);
+        write(bw, std::vector<int64_t>(300, -3));
+        write(bw, types::bytes(5000, 0xAB));
+
+        // Split into packets of 1..37 bytes, with some empty ones
+        std::vector<std::span<const uint8_t> > packets;
+        for (size_t at = 0, k = 0; at < bw.buf.size(); ++k) {
+            const size_t len = std::min(bw.buf.size() - at, k % 7 == 3 ? 0 : 1 + k * 13 % 37);
+            packets.emplace_back(bw.buf.data() + at, len);
+            at += len;
+        }
+
+        SegmentedReader sr(packets);
+        assert(sr.remaining() == bw.buf.size());
+        context ctx = context::get_default_context();
+        const auto loaded = read_batch<Order>(sr, orders.size(), ctx);
+        for (size_t i = 0; i < orders.size(); ++i)
+            assert(loaded[i].id == i && loaded[i].symbol == orders[i].symbol && loaded[i].legs == orders[i].legs);
+        assert(read<std::vector<int64_t> >(sr) == std::vector<int64_t>(300, -3));
+        assert(read<types::bytes>(sr) == types::bytes(5000, 0xAB));
+        assert(sr.remaining() == 0);
+        try {
+            (void) sr.read_byte();
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+
+        // Projection skips unwanted fields across packet boundaries
+        SegmentedReader proj(packets);
+        for (size_t i = 0; i < 3; ++i) {
+            const auto part = read_fields<Order, &Order::price>(proj);
+            assert(part.price == orders[i].price && part.symbol.empty());
+        }
+        proj.skip(proj.remaining() - 5002);
+        assert(read<types::bytes>(proj).size() == 5000);
+
+        // A borrow longer than the segments fails before anything is staged
+        SegmentedReader short_r(packets);
+        try {
+            (void) short_r.borrow_bytes(size_t{1} << 40);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+
+        std::cout << "  Segmented reader passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 31. 引用计数切片 (types::slice / SliceReader)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 31] Refcounted slices\n";
+
+        // Same wire format as types::bytes
+        Data d{3, types::bytes(3000)};
+        for (size_t i = 0; i < d.payload.size(); ++i) d.payload[i] = static_cast<uint8_t>(i * 7);
+        BufferWriter bw;
+        write(bw, d);
+        write<proto::Limited<proto::Varint, proto::Default> >(bw, d);
+
+        std::vector<Frame> frames;
+        const uint8_t *base;
+        {
+            const auto buf = types::slice::adopt(std::move(bw.buf));
+            base = buf.data();
+            SliceReader sr(buf);
+            frames.push_back(read<Frame>(sr));
+            frames.push_back(read<Frame, proto::Limited<proto::Varint, proto::Default> >(sr));
+            assert(sr.remaining() == 0);
+        }
+
+        // Decoded in place, and the buffer outlives the reader through the slices
+        for (const auto &f: frames) {
+            assert(f.id == 3 && f.payload.size() == d.payload.size());
+            assert(std::equal(f.payload.begin(), f.payload.end(), d.payload.begin()));
+        }
+        assert(frames[0].payload.data() == base + 4 + 2); // [u32 id][Varint 3000]
+        assert(frames[0].payload.owner() == frames[1].payload.owner());
+
+        // Safe to hand to another thread while this one drops its references
+        auto moved = frames[1].payload;
+        frames.clear();
+        size_t sum = 0;
+        std::thread worker([&, s = std::move(moved)] {
+            for (const uint8_t b: s) sum += b;
+        });
+        worker.join();
+        size_t expected = 0;
+        for (const uint8_t b: d.payload) expected += b;
+        assert(sum == expected);
+
+        // Other readers copy into a new buffer
+        BufferWriter out;
+        write(out, Frame{9, types::slice::copy(d.payload.data(), 100)});
+        BytesReader br(out.buf);
+        const auto copied = read<Frame>(br);
+        assert(copied.payload.to_bytes() == types::bytes(d.payload.begin(), d.payload.begin() + 100));
+        assert(copied.payload.data() < out.buf.data() || copied.payload.data() >= out.buf.data() + out.buf.size());
+        assert(copied.payload.sub(10, 5).data() == copied.payload.data() + 10);
+        try {
+            (void) copied.payload.sub(90, 20);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+
+#ifdef BSP_POSIX
+        // Fields decoded from a mapped file keep the mapping alive
+        const auto path = (std::filesystem::temp_directory_path() / "bsp_test_slices.bin").string();
+        {
+            std::ofstream f(path, std::ios::binary);
+            StreamWriter sw(f);
+            write(sw, d);
+        }
+        Frame mapped;
+        {
+            SliceReader mr(map_file(path));
+            read(mr, mapped);
+        }
+        std::filesystem::remove(path);
+        assert(mapped.payload.to_bytes() == d.payload);
+#endif
+
+        std::cout << "  Refcounted slices passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 32. 不抛出异常的读写 (try_read / try_write)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 32] Error codes without exceptions\n";
+
+        Person p{"Bob", 41, true, "bob@example.com", {1, 2, 3}};
+        Order o{7, -3, 1.5, "ABC", true, 9, {1, 2, 3}, {4, 5}};
+        Fill f{p, o, {{"desk", 1}, {"book", 2}}, 100};
+
+        BufferWriter bw;
+        write(bw, f);
+        write(bw, uint8_t{0xEE});
+
+        // Success advances the reader, a failure leaves it where it was
+        BytesReader br(bw.buf);
+        const auto ok = try_read<Fill>(br);
+        assert(ok && ok->trader.name == "Bob" && ok->order.fills == o.fills && ok->meta.at("book") == 2);
+        assert(br.pos == bw.buf.size() - 1);
+        const auto tail = try_read<uint32_t>(br);
+        assert(!tail && tail.error() == errors::code::unexpected_eof && br.pos == bw.buf.size() - 1);
+        assert(tail.value_or(5) == 5);
+        assert(try_read<uint8_t>(br).value() == 0xEE);
+
+        // Every truncation and corruption comes back as a code
+        context ctx = context::get_default_context();
+        ctx.sf.max_container_size = 4096;
+        ctx.sf.max_string_size = 4096;
+        uint32_t seed = 12345;
+        auto fuzz = [&]<typename T, typename Proto = proto::Default>(const types::bytes &valid) {
+            size_t failures = 0;
+            for (size_t n = 0; n < valid.size(); ++n) {
+                CheckedReader cr(valid.data(), n);
+                const auto out = try_read<T, Proto>(cr, ctx);
+                failures += !out;
+                assert(out || cr.error == out.error());
+            }
+            for (int round = 0; round < 300; ++round) {
+                auto bad = valid;
+                for (int k = 0; k < 3; ++k) {
+                    seed = seed * 1664525u + 1013904223u;
+                    bad[(seed >> 8) % bad.size()] = static_cast<uint8_t>(seed >> 24);
+                }
+                CheckedReader cr(bad);
+                failures += !try_read<T, Proto>(cr, ctx);
+            }
+            assert(failures >= valid.size());
+            assert(ctx.st.failure == nullptr);
+        };
+
+        auto encode = [&]<typename Proto = proto::Default>(const auto &v) {
+            BufferWriter out;
+            write<Proto>(out, v);
+            return out.buf;
+        };
+        std::vector<std::string> words{"alpha", "beta", "", "delta"};
+        std::map<std::string, std::vector<int> > groups{{"a", {1, 2}}, {"b", {}}, {"c", {3}}};
+        std::variant<int, std::string, Order> var = o;
+        std::optional<Person> opt = p;
+        context small_chunks = context::get_default_context();
+        small_chunks.opt.chunk_size = 2;
+        BufferWriter chunked;
+        write<proto::Chunked<> >(chunked, words, small_chunks);
+
+        fuzz.operator()<Fill>(encode(f));
+        fuzz.operator()<Order>(encode(o));
+        fuzz.operator()<decltype(groups)>(encode(groups));
+        fuzz.operator()<decltype(var)>(encode(var));
+        fuzz.operator()<decltype(opt)>(encode(opt));
+        fuzz.operator()<Person, proto::Versioned<> >(encode.operator()<proto::Versioned<> >(p));
+        fuzz.operator()<Quote, proto::Tagged<> >(encode.operator()<proto::Tagged<> >(Quote{1, 2.5, "XYZ", 300}));
+        fuzz.operator()<decltype(words), proto::Indexed<> >(encode.operator()<proto::Indexed<> >(words));
+        fuzz.operator()<decltype(words), proto::Chunked<> >(chunked.buf);
+
+        // Limits and policies report their own codes
+        context strict = context::get_default_context();
+        strict.sf.policy = errors::error_policy::STRICT;
+        strict.sf.max_string_size = 2;
+        CheckedReader long_name(bw.buf);
+        assert(try_read<Fill>(long_name, strict).error() == errors::code::string_too_large);
+        const types::bytes two{2};
+        CheckedReader bad_bool(two);
+        assert(try_read<bool>(bad_bool, strict).error() == errors::code::invalid_bool);
+
+        using Nested = std::vector<std::vector<std::vector<int> > >;
+        context shallow = context::get_default_context();
+        shallow.sf.max_depth = 2;
+        const auto nested = encode(Nested{{{1}}});
+        CheckedReader deep(nested);
+        assert(try_read<Nested>(deep, shallow).error() == errors::code::depth_limit_exceeded);
+
+        // Writing
+        uint8_t small[8];
+        CheckedWriter cw(small, sizeof(small));
+        assert(try_write(cw, uint64_t{1}));
+        const auto full = try_write(cw, uint8_t{1});
+        assert(!full && full.error() == errors::code::out_of_space && cw.pos == sizeof(small));
+
+        BufferWriter fixed;
+        const auto mismatch = try_write<proto::Fixed<4> >(fixed, std::string("toolong"));
+        assert(!mismatch && mismatch.error() == errors::code::fixed_size_mismatch);
+        assert(try_write<proto::Fixed<4> >(fixed, std::string("four")) && fixed.buf.size() == 4);
+
+        try {
+            (void) tail.value();
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::unexpected_eof);
+        }
+
+        std::cout << "  Error codes without exceptions passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 33. 编译期策略 (basic_context<policy>)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 33] Compile-time context policies\n";
+
+        static_assert(context::policy.traceback && !context::policy.fixed);
+        static_assert(!trusted_context::policy.traceback && !trusted_context::policy.limits);
+        static_assert(untrusted_context::policy.error_policy == errors::error_policy::STRICT);
+        static_assert(context_like<trusted_context> && !context_like<safety>);
+
+        Person p{"Bob", 41, true, "bob@example.com", {1, 2, 3}};
+        Order o{7, -3, 1.5, "ABC", true, 9, {1, 2, 3}, {4, 5}};
+        Fill f{p, o, {{"desk", 1}, {"book", 2}}, 100};
+
+        // Same bytes under every policy
+        auto trusted = trusted_context::get_default_context();
+        auto untrusted = untrusted_context::get_default_context();
+        BufferWriter plain, fast, checked;
+        write(plain, f);
+        write(fast, f, trusted);
+        write(checked, f, untrusted);
+        assert(plain.buf == fast.buf && plain.buf == checked.buf);
+        BytesReader fast_r(plain.buf);
+        const auto back = read<proto::Default, Fill>(fast_r, trusted);
+        assert(back.trader.email == p.email && back.order.fills == o.fills && back.meta == f.meta);
+
+        // The policy wins over the runtime safety settings
+        const types::bytes two{2};
+        trusted.sf.policy = errors::error_policy::STRICT;
+        trusted.sf.max_string_size = 2;
+        BytesReader bool_r(two);
+        assert((read<proto::Default, bool>(bool_r, trusted)));
+        BytesReader long_r(plain.buf);
+        assert((read<proto::Default, Fill>(long_r, trusted).trader.name == "Bob"));
+
+        untrusted.sf.policy = errors::error_policy::IGNORE;
+        BytesReader strict_r(two);
+        try {
+            (void) read<proto::Default, bool>(strict_r, untrusted);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_bool);
+        }
+
+        // Only traced policies build a traceback
+        std::variant<int, std::string> var;
+        const types::bytes bad_index{9};
+        BytesReader traced_r(bad_index);
+        try {
+            read(traced_r, var, untrusted);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.format_tb().find("std::variant") != std::string::npos);
+        }
+        BytesReader untraced_r(bad_index);
+        try {
+            read(untraced_r, var, trusted);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_index && e.tb == nullptr);
+        }
+
+        // Versioned, Chunked on a pool, CVal and try_read keep the policy of their caller
+        parallel::thread_pool pool(2);
+        trusted.opt.pool = &pool;
+        trusted.opt.chunk_size = 2;
+        std::vector<std::string> words{"alpha", "beta", "", "delta", "epsilon"};
+        MyCVal cv;
+        cv.x = 5;
+        cv.s = "cval";
+        BufferWriter mixed;
+        write<proto::Versioned<> >(mixed, p, trusted);
+        write<proto::Chunked<> >(mixed, words, trusted);
+        write(mixed, cv, trusted);
+        BytesReader mixed_r(mixed.buf);
+        assert((read<proto::Versioned<>, Person>(mixed_r, trusted).scores == p.scores));
+        assert((read<proto::Chunked<>, std::vector<std::string> >(mixed_r, trusted) == words));
+        MyCVal cv_out;
+        read(mixed_r, cv_out, untrusted);
+        assert(cv_out.x == 5 && cv_out.s == "cval" && mixed_r.pos == mixed.buf.size());
+
+        // Inside CVal, a fixed policy still checks at its own level and trusted still skips limits
+        FlagCVal flag_out;
+        BytesReader flag_r(two);
+        try {
+            read(flag_r, flag_out, untrusted);
+            assert(false);
+        } catch (const errors::error &e) {
+            assert(e.c == errors::code::invalid_bool);
+        }
+        BytesReader cval_r(mixed.buf);
+        (void) read<proto::Versioned<>, Person>(cval_r, trusted);
+        (void) read<proto::Chunked<>, std::vector<std::string> >(cval_r, trusted);
+        read(cval_r, cv_out, trusted);
+        assert(cv_out.s == "cval");
+
+        CheckedReader cut(plain.buf.data(), plain.buf.size() - 1);
+        assert(try_read<Fill>(cut, untrusted).error() == errors::code::unexpected_eof);
+
+        std::cout << "  Compile-time context policies passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 34. 有界调用栈 (errors::traceback::bounded)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 34] Bounded traceback\n";
+
+        // Two vectors around a variant with an invalid index: three frames
+        using Nested = std::vector<std::vector<std::variant<int, std::string> > >;
+        const types::bytes bad{1, 1, 9};
+        context ctx = context::get_default_context();
+        ctx.traceback = errors::traceback::bounded(2);
+        const auto *storage = ctx.traceback->frames.data();
+
+        for (int round = 0; round < 2; ++round) {
+            BytesReader r(bad);
+            try {
+                Nested out;
+                read(r, out, ctx);
+                assert(false);
+            } catch (const errors::error &e) {
+                assert(e.c == errors::code::invalid_index && e.tb == ctx.traceback);
+                const std::string tb = e.format_tb();
+                // The innermost frames are kept, the outer vector is dropped
+                assert(tb.find("outer frames dropped: 1") != std::string::npos);
+                assert(tb.find("  - [UNKNOWN] | std::vector, Varint\n    (length=1)") != std::string::npos);
+                assert(tb.find("  @ std::variant (index=9)") != std::string::npos);
+                assert(tb.find("[ROOT]") == std::string::npos);
+            }
+            // The frames reuse their storage
+            assert(ctx.traceback->frames.size() == 2 && ctx.traceback->frames.data() == storage);
+        }
+
+        // A new error starts an empty traceback, an error still held keeps its own frames
+        std::optional<errors::error> deep;
+        BytesReader deep_r(bad);
+        try {
+            Nested out;
+            read(deep_r, out, ctx);
+            assert(false);
+        } catch (const errors::error &e) {
+            deep = e;
+        }
+        const std::string deep_tb = deep->format_tb();
+        std::variant<int, std::string> shallow;
+        const types::bytes bad_index{9};
+        BytesReader shallow_r(bad_index);
+        try {
+            read(shallow_r, shallow, ctx);
+            assert(false);
+        } catch (const errors::error &e) {
+            const std::string tb = e.format_tb();
+            assert(tb.find("std::variant") != std::string::npos);
+            assert(tb.find("std::vector") == std::string::npos && tb.find("dropped") == std::string::npos);
+        }
+        assert(deep->format_tb() == deep_tb);
+
+        // Frame text is only put together by format()
+        const errors::frame_text field{"Field \"", "buy", "\""}, elem{"Elem ", 12}, owned{std::string("owned")};
+        std::string text;
+        field.append_to(text);
+        elem.append_to(text);
+        owned.append_to(text);
+        assert(text == "Field \"buy\"Elem 12owned" && errors::frame_text{}.empty());
+
+        std::cout << "  Bounded traceback passed\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // 35. pmr 容器与内存资源 (option::resource)
+    // ------------------------------------------------------------------------
+    {
+        std::cout << "\n[Test 35] pmr containers on a memory resource\n";
+
+        // Same bytes as the std containers
+        const std::map<std::string, std::vector<std::string> > books{
+            {"alpha", {"a long string that does not fit in place", "b"}}, {"beta", {}}
+        };
+        const std::set<std::string> tags{"one", "two"};
+        BufferWriter bw;
+        write(bw, books);
+        write(bw, tags);
+        const std::vector<std::string> words{"first word long enough for the heap", "second"};
+        write(bw, words);
+
+        using PmrBooks = std::pmr::map<std::pmr::string, std::pmr::vector<std::pmr::string> >;
+        PmrBooks pmr_books;
+        pmr_books.emplace("alpha", std::pmr::vector<std::pmr::string>{"a long string that does not fit in place", "b"});
+        pmr_books.emplace("beta", std::pmr::vector<std::pmr::string>{});
+        BufferWriter pmr_bw;
+        write(pmr_bw, pmr_books);
+        write(pmr_bw, std::pmr::set<std::pmr::string>{"one", "two"});
+        write(pmr_bw, std::vector<std::pmr::string>{"first word long enough for the heap", "second"});
+        assert(bw.buf == pmr_bw.buf);
+
+        // With the default resource unusable, reading succeeds only if every allocation comes from the arena
+        std::array<std::byte, 16 * 1024> storage;
+        std::pmr::monotonic_buffer_resource arena(storage.data(), storage.size(), std::pmr::null_memory_resource());
+        context ctx = context::get_default_context();
+        ctx.opt.resource = &arena;
+
+        std::pmr::memory_resource *previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+        {
+            BytesReader r(bw.buf);
+            const auto back = read<proto::Default, PmrBooks>(r, ctx);
+            std::pmr::unordered_set<std::pmr::string> back_tags;
+            read(r, back_tags, ctx);
+            std::vector<std::pmr::string> back_words(2);
+            read(r, back_words, ctx);
+
+            assert(back.get_allocator().resource() == &arena);
+            assert(back.at("alpha").get_allocator().resource() == &arena);
+            assert(back.at("alpha")[0] == "a long string that does not fit in place" && back.at("beta").empty());
+            assert(back_tags.size() == 2 && back_tags.contains("two"));
+            assert(back_words[0].get_allocator().resource() == &arena && back_words[1] == "second");
+        }
+        std::pmr::set_default_resource(previous);
+
+        // Without the option, elements follow the container they are read into
+        std::pmr::monotonic_buffer_resource local;
+        PmrBooks on_local(&local);
+        BytesReader r(bw.buf);
+        read(r, on_local);
+        assert(on_local.at("alpha")[1].get_allocator().resource() == &local);
+
+        std::cout << "  pmr containers passed\n";
+    }
+
     std::cout << "\n=== All compilation tests passed successfully ===\n";
     return 0;
 }
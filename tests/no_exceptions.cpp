@@ -0,0 +1,60 @@
+#include "../include/bsp.hpp"
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Build: g++ -std=c++20 -fno-exceptions -o no_exceptions tests/no_exceptions.cpp
+// Any error that is not returned as a code aborts through errors::fatal_handler.
+
+struct Order {
+    uint64_t id;
+    std::string symbol;
+    std::optional<double> price;
+    std::vector<uint32_t> fills;
+    std::map<std::string, int> meta;
+};
+
+BSP_SCHEMA_SET(Order,
+               BSP_SCHEMA(BSP_FIELD(id), BSP_FIELD(symbol), BSP_FIELD(price), BSP_FIELD(fills), BSP_FIELD(meta))
+);
+
+int main() {
+    using namespace bsp;
+    using namespace bsp::io;
+
+    const Order o{7, "ABC", 1.5, {4, 5, 6}, {{"desk", 1}}};
+    BufferWriter bw;
+    write(bw, o);
+    write<proto::Versioned<> >(bw, o);
+
+    BytesReader br(bw.buf);
+    const auto plain = try_read<Order>(br);
+    const auto versioned = try_read<Order, proto::Versioned<> >(br);
+    assert(plain && versioned && versioned->meta.at("desk") == 1 && br.pos == bw.buf.size());
+
+    context ctx = context::get_default_context();
+    ctx.sf.max_container_size = 4096;
+    ctx.sf.max_string_size = 4096;
+    size_t failures = 0;
+    uint32_t seed = 1;
+    for (int round = 0; round < 20000; ++round) {
+        auto bad = bw.buf;
+        for (int k = 0; k < 4; ++k) {
+            seed = seed * 1664525u + 1013904223u;
+            bad[(seed >> 8) % bad.size()] = static_cast<uint8_t>(seed >> 24);
+        }
+        CheckedReader cr(bad.data(), seed % (bad.size() + 1));
+        failures += !try_read<Order>(cr, ctx);
+        failures += !try_read<Order, proto::Versioned<> >(cr, ctx);
+    }
+
+    uint8_t small[4];
+    CheckedWriter cw(small, sizeof(small));
+    assert(try_write(cw, o).error() == errors::code::out_of_space);
+
+    std::printf("%zu of 40000 corrupted reads failed with a code\n", failures);
+    return 0;
+}